@@ -0,0 +1,311 @@
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+
+#include "benchmark.cpp"
+#include "../labcpp-2/chessboard.cpp"
+#include "../labcpp-3/custstl.cpp"
+#include "../labcpp-3/complex.cpp"
+
+// Benchmarks for the hot paths of the labs: List<T> from labcpp-3, Complex and ChessBoard.
+// Build with optimisation (see the "C/C++: g++ build benchmarks (optimised)" task in .vscode/tasks.json), e.g.
+//   g++ -O2 -std=c++17 bench/bench.cpp -o bench/bench
+//
+// Usage: bench [--sizes 16,256,4096] [--samples N] [--warmup N] [--min-time ms] [--filter text] [--json file]
+// With --json - the JSON report goes to stdout instead of the table.
+
+const char MIDDLEGAME_FEN[] = "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R2QKB1R w KQ - 0 9";
+
+template <typename T>
+void fillList(List<T>& list, long size, T (*makeValue)(long)) {
+    for (long i = 0; i < size; ++i) {
+        list.add(makeValue(i));
+    }
+}
+
+int makeInt(long i) {
+    return (int)i;
+}
+
+Complex makeComplex(long i) {
+    return Complex(i, -i);
+}
+
+// Every List benchmark works on a list of `size` elements, values makeValue(0 .. size - 1)
+template <typename T>
+void addListBenchmarks(std::vector<Benchmark>& benchmarks, const std::string& type, long size, T (*makeValue)(long)) {
+    const std::string prefix = "List<" + type + ">::";
+    auto list = std::make_shared<List<T>>();
+    auto lists = std::make_shared<std::vector<std::unique_ptr<List<T>>>>();
+    auto output = std::make_shared<NullBuffer>();
+
+    // Appends to a list that is emptied before every sample
+    benchmarks.push_back(Benchmark{prefix + "add", size,
+        [=](uint64_t) { list->clear(); },
+        [=](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) list->add(makeValue(i % size));
+        }, 1 << 20});
+
+    // Inserts in the middle, so every call walks size / 2 nodes
+    benchmarks.push_back(Benchmark{prefix + "insert", size,
+        [=](uint64_t) { list->clear(); fillList(*list, size, makeValue); },
+        [=](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) list->insert(size / 2, makeValue(i % size));
+        }, 1 << 20});
+
+    benchmarks.push_back(Benchmark{prefix + "find/hit", size,
+        [=](uint64_t) { list->clear(); fillList(*list, size, makeValue); },
+        [=](uint64_t iterations) {
+            T value = makeValue(size / 2);
+            for (uint64_t i = 0; i < iterations; ++i) {
+                bool found = list->find(value);
+                doNotOptimize(found);
+            }
+        }});
+
+    benchmarks.push_back(Benchmark{prefix + "find/miss", size,
+        [=](uint64_t) { list->clear(); fillList(*list, size, makeValue); },
+        [=](uint64_t iterations) {
+            T value = makeValue(-1);
+            for (uint64_t i = 0; i < iterations; ++i) {
+                bool found = list->find(value);
+                doNotOptimize(found);
+            }
+        }});
+
+    // The list holds size distinct values followed by one copy of makeValue(size) per operation,
+    // so every remove walks past the same size nodes before it finds its victim
+    benchmarks.push_back(Benchmark{prefix + "remove", size,
+        [=](uint64_t iterations) {
+            list->clear();
+            fillList(*list, size, makeValue);
+            for (uint64_t i = 0; i < iterations; ++i) list->add(makeValue(size));
+        },
+        [=](uint64_t iterations) {
+            T value = makeValue(size);
+            for (uint64_t i = 0; i < iterations; ++i) list->remove(value);
+        }, 1 << 16});
+
+    // One operation clears a whole list; as many lists as operations are built beforehand
+    benchmarks.push_back(Benchmark{prefix + "clear", size,
+        [=](uint64_t iterations) {
+            lists->clear();
+            for (uint64_t i = 0; i < iterations; ++i) {
+                lists->emplace_back(new List<T>());
+                fillList(*lists->back(), size, makeValue);
+            }
+        },
+        [=](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) (*lists)[i]->clear();
+        }, std::max<uint64_t>(1, (1 << 22) / size)});
+
+    // One operation prints the whole list into a stream that discards it
+    benchmarks.push_back(Benchmark{prefix + "print", size,
+        [=](uint64_t) { list->clear(); fillList(*list, size, makeValue); },
+        [=](uint64_t iterations) {
+            std::ostream out(output.get());
+            for (uint64_t i = 0; i < iterations; ++i) list->print(out);
+        }});
+}
+
+// Each operation applies the operator to the next pair of a small table of operands
+void addComplexBenchmarks(std::vector<Benchmark>& benchmarks) {
+    const int count = 1024;
+    auto operands = std::make_shared<std::vector<Complex>>();
+    for (int i = 0; i < count; ++i) {
+        operands->push_back(Complex(1 + i % 37, 2 - i % 11));
+    }
+    auto output = std::make_shared<NullBuffer>();
+    auto stream = std::make_shared<std::ostream>(output.get());
+
+    // Generic so that each operation is inlined into its own loop
+    auto binary = [&](const std::string& name, auto operation) {
+        benchmarks.push_back(Benchmark{"Complex::" + name, 0, nullptr,
+            [=](uint64_t iterations) {
+                const std::vector<Complex>& values = *operands;
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    operation(values[i % count], values[(i + 1) % count]);
+                }
+            }});
+    };
+
+    binary("Complex(r, i)", [](const Complex& a, const Complex& b) {
+        Complex result(a.getReal(), b.getImag());
+        doNotOptimize(result);
+    });
+    binary("operator+", [](const Complex& a, const Complex& b) {
+        Complex result = a + b;
+        doNotOptimize(result);
+    });
+    binary("operator-", [](const Complex& a, const Complex& b) {
+        Complex result = a - b;
+        doNotOptimize(result);
+    });
+    binary("operator*", [](const Complex& a, const Complex& b) {
+        Complex result = a * b;
+        doNotOptimize(result);
+    });
+    binary("operator/", [](const Complex& a, const Complex& b) {
+        Complex result = a / b;
+        doNotOptimize(result);
+    });
+    binary("operator<", [](const Complex& a, const Complex& b) {
+        bool result = a < b;
+        doNotOptimize(result);
+    });
+    binary("operator>", [](const Complex& a, const Complex& b) {
+        bool result = a > b;
+        doNotOptimize(result);
+    });
+    binary("operator==", [](const Complex& a, const Complex& b) {
+        bool result = a == b;
+        doNotOptimize(result);
+    });
+    binary("modulus", [](const Complex& a, const Complex&) {
+        ld result = a.modulus();
+        doNotOptimize(result);
+    });
+    binary("operator<<", [output, stream](const Complex& a, const Complex&) {
+        *stream << a;
+    });
+}
+
+// The starting position, piece by piece, as in labcpp-2/main.cpp
+void placeStartingPieces(ChessBoard& board) {
+    const char* backRank = "RNBQKBNR";
+    for (int file = 0; file < BOARD_SIZE; ++file) {
+        std::string column(1, (char)('A' + file));
+        for (int c = WHITE; c <= BLACK; ++c) {
+            Color color = (Color)c;
+            Piece* piece = nullptr;
+            switch (backRank[file]) {
+                case 'R': piece = new Rook(color); break;
+                case 'N': piece = new Knight(color); break;
+                case 'B': piece = new Bishop(color); break;
+                case 'Q': piece = new Queen(color); break;
+                case 'K': piece = new King(color); break;
+            }
+            board.placePiece(piece, column + (color == WHITE ? "1" : "8"));
+            board.placePiece(new Pawn(color), column + (color == WHITE ? "2" : "7"));
+        }
+    }
+}
+
+void addChessBoardBenchmarks(std::vector<Benchmark>& benchmarks) {
+    // One operation builds a board and places all 32 pieces of the starting position
+    benchmarks.push_back(Benchmark{"ChessBoard::placePiece/x32", 0, nullptr,
+        [](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                ChessBoard board;
+                placeStartingPieces(board);
+                doNotOptimize(board);
+            }
+        }});
+
+    auto start = std::make_shared<ChessBoard>();
+    placeStartingPieces(*start);
+    auto middlegame = std::make_shared<ChessBoard>();
+    middlegame->setFEN(MIDDLEGAME_FEN);
+
+    const std::pair<const char*, std::shared_ptr<ChessBoard>> boards[] = {{"start", start}, {"middlegame", middlegame}};
+    for (const auto& entry : boards) {
+        std::shared_ptr<ChessBoard> board = entry.second;
+        benchmarks.push_back(Benchmark{std::string("ChessBoard::toFEN/") + entry.first, 0, nullptr,
+            [board](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    std::string fen = board->toFEN();
+                    doNotOptimize(fen);
+                }
+            }});
+    }
+
+    // displayBoard writes to std::cout, which is pointed at a discarding buffer while it runs
+    auto output = std::make_shared<NullBuffer>();
+    benchmarks.push_back(Benchmark{"ChessBoard::displayBoard", 0, nullptr,
+        [start, output](uint64_t iterations) {
+            std::streambuf* saved = std::cout.rdbuf(output.get());
+            for (uint64_t i = 0; i < iterations; ++i) {
+                start->displayBoard();
+            }
+            std::cout.rdbuf(saved);
+        }});
+}
+
+bool parseSizes(const std::string& text, std::vector<long>& sizes) {
+    sizes.clear();
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        char* end;
+        long size = std::strtol(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || size <= 0) {
+            return false;
+        }
+        sizes.push_back(size);
+    }
+    return !sizes.empty();
+}
+
+int main(int argc, char* argv[]) {
+    BenchmarkConfig config;
+    std::vector<long> sizes = {16, 256, 4096};
+    std::string filter;
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (argument == "--sizes" && hasValue && parseSizes(argv[i + 1], sizes)) {
+            ++i;
+        } else if (argument == "--samples" && hasValue && std::atoi(argv[i + 1]) > 0) {
+            config.samples = std::atoi(argv[++i]);
+        } else if (argument == "--warmup" && hasValue && std::atoi(argv[i + 1]) >= 0) {
+            config.warmupSamples = std::atoi(argv[++i]);
+        } else if (argument == "--min-time" && hasValue && std::atof(argv[i + 1]) > 0) {
+            config.minSampleTime = std::atof(argv[++i]) / 1000;
+        } else if (argument == "--filter" && hasValue) {
+            filter = argv[++i];
+        } else if (argument == "--json" && hasValue) {
+            jsonPath = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--sizes 16,256,4096] [--samples N] [--warmup N]"
+                      << " [--min-time ms] [--filter text] [--json file|-]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Benchmark> benchmarks;
+    for (long size : sizes) {
+        addListBenchmarks<int>(benchmarks, "int", size, makeInt);
+    }
+    for (long size : sizes) {
+        addListBenchmarks<Complex>(benchmarks, "Complex", size, makeComplex);
+    }
+    addComplexBenchmarks(benchmarks);
+    addChessBoardBenchmarks(benchmarks);
+
+    PerfCounters perf;
+    std::vector<BenchmarkResult> results;
+    bool table = jsonPath != "-";
+    for (const Benchmark& benchmark : benchmarks) {
+        if (!filter.empty() && benchmark.name.find(filter) == std::string::npos) continue;
+        results.push_back(runBenchmark(benchmark, config, perf));
+        if (table) std::cerr << "." << std::flush;
+    }
+    if (table) {
+        std::cerr << "\n";
+        printTextReport(std::cout, results);
+    }
+
+    if (jsonPath == "-") {
+        printJsonReport(std::cout, results, config);
+    } else if (!jsonPath.empty()) {
+        std::ofstream file(jsonPath);
+        if (!file) {
+            std::cerr << "Cannot write " << jsonPath << std::endl;
+            return 1;
+        }
+        printJsonReport(file, results, config);
+    }
+    return 0;
+}
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Small benchmark harness: every benchmark is calibrated until one sample takes at least
+// minSampleTime, run for a few warmup samples that are thrown away, and then measured over a
+// fixed number of samples. Results are reported as nanoseconds per operation.
+
+// Keeps the compiler from dropping a computation whose result is never used
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+inline void clobberMemory() {
+    asm volatile("" : : : "memory");
+}
+
+// Discards everything written to it; used to time printing without a terminal in the way
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override {
+        return c;
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize count) override {
+        return count;
+    }
+};
+
+enum CounterId {
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_BRANCH_MISSES,
+    COUNTER_CACHE_MISSES,
+    COUNTER_COUNT
+};
+
+const char* const COUNTER_NAMES[COUNTER_COUNT] = {"cycles", "instructions", "branch_misses", "cache_misses"};
+
+// Hardware counters of the calling thread, read through perf_event_open as one group so that
+// all of them cover exactly the same instructions. On kernels or containers that do not allow
+// it, available() is false and every reading is zero.
+class PerfCounters {
+private:
+    int fds[COUNTER_COUNT];
+    int ids[COUNTER_COUNT];
+    int active;
+
+#ifdef __linux__
+    static int openCounter(uint64_t config, int groupFd) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = groupFd == -1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return (int)syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0);
+    }
+#endif
+
+public:
+    PerfCounters() : active(0) {
+        for (int i = 0; i < COUNTER_COUNT; ++i) {
+            fds[i] = -1;
+            ids[i] = -1;
+        }
+#ifdef __linux__
+        const uint64_t configs[COUNTER_COUNT] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                 PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES};
+        for (int i = 0; i < COUNTER_COUNT; ++i) {
+            fds[i] = openCounter(configs[i], active ? fds[0] : -1);
+            if (fds[i] >= 0) {
+                ids[i] = active++;
+            } else if (i == 0) {
+                return;
+            }
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int i = 0; i < COUNTER_COUNT; ++i) {
+            if (fds[i] >= 0) close(fds[i]);
+        }
+#endif
+    }
+
+    bool available() const {
+        return active > 0;
+    }
+
+    bool has(CounterId counter) const {
+        return ids[counter] >= 0;
+    }
+
+    void start() {
+#ifdef __linux__
+        if (!active) return;
+        ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    // Stops counting and adds the readings to totals, scaled up if the kernel had to multiplex
+    void stop(double totals[COUNTER_COUNT]) {
+#ifdef __linux__
+        if (!active) return;
+        ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        uint64_t buffer[3 + COUNTER_COUNT];
+        if (read(fds[0], buffer, sizeof(buffer)) < (ssize_t)(3 * sizeof(uint64_t))) return;
+        uint64_t enabled = buffer[1];
+        uint64_t running = buffer[2];
+        double scale = running ? (double)enabled / running : 0;
+        for (int i = 0; i < COUNTER_COUNT; ++i) {
+            if (ids[i] >= 0 && ids[i] < (int)buffer[0]) {
+                totals[i] += buffer[3 + ids[i]] * scale;
+            }
+        }
+#else
+        (void)totals;
+#endif
+    }
+};
+
+struct BenchmarkConfig {
+    int warmupSamples = 3;
+    int samples = 15;
+    double minSampleTime = 0.01; // seconds
+    uint64_t maxIterations = 1 << 24;
+};
+
+struct Benchmark {
+    std::string name;
+    long size; // 0 when the benchmark does not depend on a size
+    // Called before every sample with the number of operations it is going to run; not timed
+    std::function<void(uint64_t)> setup;
+    // Runs the given number of operations
+    std::function<void(uint64_t)> run;
+    uint64_t maxIterations = 0; // 0 means no limit besides BenchmarkConfig::maxIterations
+};
+
+struct BenchmarkResult {
+    std::string name;
+    long size;
+    uint64_t iterations; // operations per sample
+    std::vector<double> samples; // nanoseconds per operation, sorted
+
+    double min, max, mean, median, p90, p99, stddev;
+    bool hasCounters;
+    bool hasCounter[COUNTER_COUNT];
+    double counters[COUNTER_COUNT]; // per operation
+};
+
+// Nearest-rank percentile of sorted values
+inline double percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    size_t rank = (size_t)std::ceil(fraction * sorted.size());
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+inline double sampleSeconds(const Benchmark& benchmark, uint64_t iterations) {
+    if (benchmark.setup) benchmark.setup(iterations);
+    auto start = std::chrono::steady_clock::now();
+    benchmark.run(iterations);
+    clobberMemory();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline BenchmarkResult runBenchmark(const Benchmark& benchmark, const BenchmarkConfig& config, PerfCounters& perf) {
+    uint64_t limit = config.maxIterations;
+    if (benchmark.maxIterations) limit = std::min(limit, benchmark.maxIterations);
+
+    // Grow the sample until it is long enough to time reliably
+    uint64_t iterations = 1;
+    for (;;) {
+        double seconds = sampleSeconds(benchmark, iterations);
+        if (seconds >= config.minSampleTime || iterations >= limit) break;
+        double factor = seconds > 0 ? 1.2 * config.minSampleTime / seconds : 10;
+        iterations = std::min(limit, (uint64_t)(iterations * std::min(10.0, std::max(2.0, factor))));
+    }
+
+    for (int i = 0; i < config.warmupSamples; ++i) {
+        sampleSeconds(benchmark, iterations);
+    }
+
+    BenchmarkResult result;
+    result.name = benchmark.name;
+    result.size = benchmark.size;
+    result.iterations = iterations;
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        result.counters[i] = 0;
+        result.hasCounter[i] = perf.has((CounterId)i);
+    }
+    result.hasCounters = perf.available();
+
+    for (int i = 0; i < config.samples; ++i) {
+        if (benchmark.setup) benchmark.setup(iterations);
+        perf.start();
+        auto start = std::chrono::steady_clock::now();
+        benchmark.run(iterations);
+        clobberMemory();
+        auto end = std::chrono::steady_clock::now();
+        perf.stop(result.counters);
+        result.samples.push_back(std::chrono::duration<double, std::nano>(end - start).count() / iterations);
+    }
+
+    std::vector<double>& samples = result.samples;
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double sample : samples) sum += sample;
+    result.mean = sum / samples.size();
+    double squares = 0;
+    for (double sample : samples) squares += (sample - result.mean) * (sample - result.mean);
+    result.stddev = samples.size() > 1 ? std::sqrt(squares / (samples.size() - 1)) : 0;
+    result.min = samples.front();
+    result.max = samples.back();
+    result.median = samples.size() % 2 ? samples[samples.size() / 2]
+                                       : (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2;
+    result.p90 = percentile(samples, 0.90);
+    result.p99 = percentile(samples, 0.99);
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        result.counters[i] /= (double)iterations * config.samples;
+    }
+    return result;
+}
+
+inline std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if ((unsigned char)c < 0x20) {
+            char buffer[8];
+            snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+            escaped += buffer;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+inline void printTextReport(std::ostream& out, const std::vector<BenchmarkResult>& results) {
+    out << std::left << std::setw(34) << "benchmark" << std::right << std::setw(8) << "size" << std::setw(12) << "median"
+        << std::setw(12) << "p90" << std::setw(12) << "p99" << std::setw(9) << "stddev" << std::setw(11) << "iters";
+    bool counters = !results.empty() && results[0].hasCounters;
+    if (counters) out << std::setw(10) << "cycles" << std::setw(10) << "instr" << std::setw(9) << "br-miss"
+                      << std::setw(9) << "$-miss";
+    out << "\n";
+
+    out << std::fixed;
+    for (const BenchmarkResult& result : results) {
+        out << std::left << std::setw(34) << result.name << std::right << std::setw(8);
+        if (result.size) out << result.size;
+        else out << "-";
+        out << std::setprecision(1) << std::setw(10) << result.median << "ns" << std::setw(10) << result.p90 << "ns"
+            << std::setw(10) << result.p99 << "ns" << std::setw(8) << 100 * result.stddev / result.mean << "%"
+            << std::setw(11) << result.iterations;
+        if (result.hasCounters) {
+            out << std::setprecision(1);
+            const int widths[COUNTER_COUNT] = {10, 10, 9, 9};
+            for (int i = 0; i < COUNTER_COUNT; ++i) {
+                out << std::setw(widths[i]);
+                if (result.hasCounter[i]) out << result.counters[i];
+                else out << "-";
+            }
+        }
+        out << "\n";
+    }
+    out << std::defaultfloat;
+    if (!counters) out << "(hardware counters are not available)\n";
+}
+
+// extra, if given, is inserted as further members of the top-level object, e.g. "\"name\": [...]"
+inline void printJsonReport(std::ostream& out, const std::vector<BenchmarkResult>& results, const BenchmarkConfig& config,
+                            const std::string& extra = "") {
+    char date[32];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    out << std::setprecision(6);
+    out << "{\n";
+    out << "  \"context\": {\n";
+    out << "    \"date\": \"" << date << "\",\n";
+#ifdef __VERSION__
+    out << "    \"compiler\": \"" << jsonEscape(__VERSION__) << "\",\n";
+#endif
+#ifdef __OPTIMIZE__
+    out << "    \"optimized\": true,\n";
+#else
+    out << "    \"optimized\": false,\n";
+#endif
+    out << "    \"warmup_samples\": " << config.warmupSamples << ",\n";
+    out << "    \"samples\": " << config.samples << ",\n";
+    out << "    \"min_sample_time\": " << config.minSampleTime << ",\n";
+    out << "    \"hardware_counters\": " << (!results.empty() && results[0].hasCounters ? "true" : "false") << "\n";
+    out << "  },\n";
+    out << "  \"benchmarks\": [";
+    for (size_t r = 0; r < results.size(); ++r) {
+        const BenchmarkResult& result = results[r];
+        out << (r ? ",\n" : "\n") << "    {\n";
+        out << "      \"name\": \"" << jsonEscape(result.name) << "\",\n";
+        out << "      \"size\": " << result.size << ",\n";
+        out << "      \"iterations\": " << result.iterations << ",\n";
+        out << "      \"unit\": \"ns/op\",\n";
+        out << "      \"min\": " << result.min << ", \"median\": " << result.median << ", \"mean\": " << result.mean
+            << ", \"p90\": " << result.p90 << ", \"p99\": " << result.p99 << ", \"max\": " << result.max
+            << ", \"stddev\": " << result.stddev << ",\n";
+        out << "      \"samples\": [";
+        for (size_t i = 0; i < result.samples.size(); ++i) {
+            out << (i ? ", " : "") << result.samples[i];
+        }
+        out << "],\n";
+        out << "      \"counters\": {";
+        bool first = true;
+        for (int i = 0; i < COUNTER_COUNT; ++i) {
+            if (!result.hasCounter[i]) continue;
+            out << (first ? "" : ", ") << "\"" << COUNTER_NAMES[i] << "\": " << result.counters[i];
+            first = false;
+        }
+        out << "}\n";
+        out << "    }";
+    }
+    out << "\n  ]";
+    if (!extra.empty()) out << ",\n  " << extra;
+    out << "\n}\n";
+}
@@ -0,0 +1,265 @@
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "benchmark.cpp"
+#include "../labcpp-3/custstl.cpp"
+#include "../labcpp-3/complex.cpp"
+#include "../labcpp-3/persistent.cpp"
+
+// Snapshots of List<Complex> (a deep copy) against PersistentList<Complex> (a shared O(1) copy):
+// what a snapshot costs, what the first writes after it cost, and how fast readers can walk
+// snapshots while a writer keeps appending.
+//   g++ -O2 -std=c++17 -pthread bench/snapshot.cpp -o bench/snapshot
+//
+// Usage: snapshot [--sizes 256,4096,65536] [--readers N] [--duration ms] [--samples N] [--json file|-]
+
+Complex makeComplex(long i) {
+    return Complex(i, -i);
+}
+
+template <typename L>
+void fillList(L& list, long size) {
+    for (long i = 0; i < size; ++i) {
+        list.add(makeComplex(i));
+    }
+}
+
+void addSnapshotBenchmarks(std::vector<Benchmark>& benchmarks, long size) {
+    auto list = std::make_shared<List<Complex>>();
+    auto persistent = std::make_shared<PersistentList<Complex>>();
+    auto snapshots = std::make_shared<std::vector<PersistentList<Complex>>>();
+    fillList(*list, size);
+    fillList(*persistent, size);
+
+    benchmarks.push_back(Benchmark{"List::copy", size, nullptr,
+        [=](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                List<Complex> copy(*list);
+                doNotOptimize(copy);
+            }
+        }});
+
+    benchmarks.push_back(Benchmark{"PersistentList::copy", size, nullptr,
+        [=](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                PersistentList<Complex> copy(*persistent);
+                doNotOptimize(copy);
+            }
+        }});
+
+    // Appending while a snapshot holds the whole list: the tail is shared but still claimable
+    benchmarks.push_back(Benchmark{"PersistentList::add/shared", size,
+        [=](uint64_t) {
+            persistent->clear();
+            fillList(*persistent, size);
+            snapshots->assign(1, *persistent);
+        },
+        [=](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) persistent->add(makeComplex(i));
+        }, 1 << 20});
+
+    // One operation takes a snapshot and then removes the middle element, which copies the first
+    // half of the list; the snapshots are kept alive until the next sample
+    benchmarks.push_back(Benchmark{"PersistentList::snapshot+remove", size,
+        [=](uint64_t iterations) {
+            snapshots->clear();
+            snapshots->reserve(iterations);
+            persistent->clear();
+            fillList(*persistent, size);
+            for (long i = 0; i < (long)iterations; ++i) persistent->add(makeComplex(size + i));
+        },
+        [=](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                snapshots->push_back(*persistent);
+                persistent->remove(makeComplex(size / 2 + i));
+            }
+        }, std::max<uint64_t>(1, (1 << 22) / size)});
+
+    benchmarks.push_back(Benchmark{"List::copy+remove", size, nullptr,
+        [=](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                List<Complex> copy(*list);
+                copy.remove(makeComplex(size / 2));
+                doNotOptimize(copy);
+            }
+        }});
+
+    benchmarks.push_back(Benchmark{"List::find/miss", size, nullptr,
+        [=](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                bool found = list->find(makeComplex(-1));
+                doNotOptimize(found);
+            }
+        }});
+
+    benchmarks.push_back(Benchmark{"PersistentList::find/miss", size, nullptr,
+        [=](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                bool found = persistent->find(makeComplex(-1));
+                doNotOptimize(found);
+            }
+        }});
+}
+
+struct ConcurrentResult {
+    std::string list;
+    long size;
+    int readers;
+    double seconds;
+    uint64_t writes;
+    uint64_t snapshots;
+    uint64_t nodesRead;
+};
+
+// The writer keeps a window of `size` elements, appending at the tail and dropping the head,
+// and publishes a snapshot after every `size / 16` writes. Each reader repeatedly takes the
+// latest snapshot and walks all of it with a find that never matches.
+template <typename L>
+ConcurrentResult runConcurrent(const std::string& name, long size, int readerCount, double seconds) {
+    std::mutex mutex;
+    L writerList;
+    fillList(writerList, size);
+    std::shared_ptr<L> published = std::make_shared<L>(writerList);
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> nodesRead{0}, snapshots{0};
+    uint64_t writes = 0;
+    long publishEvery = std::max(1L, size / 16);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < readerCount; ++r) {
+        readers.emplace_back([&] {
+            uint64_t nodes = 0, taken = 0;
+            const Complex missing = makeComplex(-1);
+            while (!stop.load(std::memory_order_relaxed)) {
+                std::shared_ptr<L> snapshot;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    snapshot = published;
+                }
+                ++taken;
+                nodes += size;
+                bool found = snapshot->find(missing);
+                doNotOptimize(found);
+            }
+            nodesRead += nodes;
+            snapshots += taken;
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration<double>(seconds);
+    for (long next = size; std::chrono::steady_clock::now() < deadline;) {
+        for (long i = 0; i < publishEvery; ++i, ++next, ++writes) {
+            writerList.add(makeComplex(next));
+            writerList.remove(makeComplex(next - size));
+        }
+        // The copy is the snapshot: deep for List, O(1) for PersistentList
+        std::shared_ptr<L> snapshot = std::make_shared<L>(writerList);
+        std::lock_guard<std::mutex> lock(mutex);
+        published = snapshot;
+    }
+    stop = true;
+    for (std::thread& reader : readers) reader.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return ConcurrentResult{name, size, readerCount, elapsed, writes, snapshots, nodesRead};
+}
+
+bool parseSizes(const std::string& text, std::vector<long>& sizes) {
+    sizes.clear();
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        char* end;
+        long size = std::strtol(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || size <= 0) {
+            return false;
+        }
+        sizes.push_back(size);
+    }
+    return !sizes.empty();
+}
+
+int main(int argc, char* argv[]) {
+    BenchmarkConfig config;
+    std::vector<long> sizes = {256, 4096, 65536};
+    int readers = 2;
+    double duration = 0.5;
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (argument == "--sizes" && hasValue && parseSizes(argv[i + 1], sizes)) {
+            ++i;
+        } else if (argument == "--readers" && hasValue && std::atoi(argv[i + 1]) > 0) {
+            readers = std::atoi(argv[++i]);
+        } else if (argument == "--duration" && hasValue && std::atof(argv[i + 1]) > 0) {
+            duration = std::atof(argv[++i]) / 1000;
+        } else if (argument == "--samples" && hasValue && std::atoi(argv[i + 1]) > 0) {
+            config.samples = std::atoi(argv[++i]);
+        } else if (argument == "--json" && hasValue) {
+            jsonPath = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--sizes 256,4096,65536] [--readers N] [--duration ms]"
+                      << " [--samples N] [--json file|-]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Benchmark> benchmarks;
+    for (long size : sizes) {
+        addSnapshotBenchmarks(benchmarks, size);
+    }
+    PerfCounters perf;
+    std::vector<BenchmarkResult> results;
+    for (const Benchmark& benchmark : benchmarks) {
+        results.push_back(runBenchmark(benchmark, config, perf));
+    }
+
+    std::vector<ConcurrentResult> concurrent;
+    for (long size : sizes) {
+        concurrent.push_back(runConcurrent<List<Complex>>("List (deep copy)", size, readers, duration));
+        concurrent.push_back(runConcurrent<PersistentList<Complex>>("PersistentList", size, readers, duration));
+    }
+
+    std::ostringstream extra;
+    extra << "\"concurrent\": [";
+    for (size_t i = 0; i < concurrent.size(); ++i) {
+        const ConcurrentResult& result = concurrent[i];
+        extra << (i ? ",\n    " : "\n    ") << "{\"list\": \"" << result.list << "\", \"size\": " << result.size
+              << ", \"readers\": " << result.readers << ", \"seconds\": " << result.seconds
+              << ", \"writes_per_second\": " << result.writes / result.seconds
+              << ", \"snapshots_per_second\": " << result.snapshots / result.seconds
+              << ", \"nodes_read_per_second\": " << result.nodesRead / result.seconds << "}";
+    }
+    extra << "\n  ]";
+
+    if (jsonPath != "-") {
+        printTextReport(std::cout, results);
+        std::cout << "\nConcurrent: one writer, " << readers << " readers, " << (int)(duration * 1000) << " ms each\n";
+        std::cout << std::left << std::setw(20) << "list" << std::right << std::setw(8) << "size" << std::setw(14)
+                  << "writes/s" << std::setw(14) << "snapshots/s" << std::setw(16) << "nodes read/s" << "\n";
+        for (const ConcurrentResult& result : concurrent) {
+            std::cout << std::left << std::setw(20) << result.list << std::right << std::setw(8) << result.size
+                      << std::setprecision(3) << std::setw(14) << result.writes / result.seconds << std::setw(14)
+                      << result.snapshots / result.seconds << std::setw(16) << result.nodesRead / result.seconds << "\n";
+        }
+    }
+
+    if (jsonPath == "-") {
+        printJsonReport(std::cout, results, config, extra.str());
+    } else if (!jsonPath.empty()) {
+        std::ofstream file(jsonPath);
+        if (!file) {
+            std::cerr << "Cannot write " << jsonPath << std::endl;
+            return 1;
+        }
+        printJsonReport(file, results, config, extra.str());
+    }
+    return 0;
+}
@@ -16,6 +16,23 @@ private:
 public:
     List() : head(nullptr), tail(nullptr) {}
 
+    // Copies are deep
+    List(const List& other) : head(nullptr), tail(nullptr) {
+        for (Node* current = other.head; current != nullptr; current = current->next) {
+            add(current->data);
+        }
+    }
+
+    List& operator=(const List& other) {
+        if (this != &other) {
+            clear();
+            for (Node* current = other.head; current != nullptr; current = current->next) {
+                add(current->data);
+            }
+        }
+        return *this;
+    }
+
     ~List() {
         clear();
     }
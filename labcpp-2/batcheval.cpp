@@ -0,0 +1,400 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <immintrin.h>
+
+#include "chessboard.cpp"
+
+// Static evaluation of many positions at once.
+//
+// The score of a position is material (from Piece::value()), a piece-square bonus and mobility,
+// in centipawns from the side to move's point of view. evaluatePosition() computes it for one
+// ChessBoard, square by square. PositionBatch stores N positions as 12 arrays of bitboards (one
+// per color and piece type) and evaluateBatch() scores them with bitwise and popcount kernels,
+// several positions per instruction with AVX2 or AVX-512. Both give exactly the same numbers:
+//
+// - a piece-square table is split into bit planes, so its sum over a set of pieces is
+//   base * popcount(set) + sum of popcount(set & plane[b]) << b;
+// - mobility is counted per direction: in one direction the rays of different pieces never
+//   overlap (a ray stops at the first piece it meets), so popcount of all of them together
+//   equals the sum over single pieces.
+//
+// This is a scoring function of its own, for offline batch work such as scorefens; it is not
+// the evaluate() that search.cpp uses, which stays material only.
+//
+// Bitboards use the board's square numbering: bit y * 8 + x, with y = 0 on the 8th rank.
+
+// Centipawns per square a piece attacks that is not occupied by its own side
+const int MOBILITY_WEIGHTS[6] = {0, 4, 5, 2, 1, 0}; // PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING
+
+// Piece-square tables for white, square 0 = a8; black uses the same tables mirrored vertically
+const int PIECE_SQUARE_TABLES[6][64] = {
+    { // Pawn
+          0,   0,   0,   0,   0,   0,   0,   0,
+         50,  50,  50,  50,  50,  50,  50,  50,
+         10,  10,  20,  30,  30,  20,  10,  10,
+          5,   5,  10,  25,  25,  10,   5,   5,
+          0,   0,   0,  20,  20,   0,   0,   0,
+          5,  -5, -10,   0,   0, -10,  -5,   5,
+          5,  10,  10, -20, -20,  10,  10,   5,
+          0,   0,   0,   0,   0,   0,   0,   0
+    },
+    { // Knight
+        -50, -40, -30, -30, -30, -30, -40, -50,
+        -40, -20,   0,   0,   0,   0, -20, -40,
+        -30,   0,  10,  15,  15,  10,   0, -30,
+        -30,   5,  15,  20,  20,  15,   5, -30,
+        -30,   0,  15,  20,  20,  15,   0, -30,
+        -30,   5,  10,  15,  15,  10,   5, -30,
+        -40, -20,   0,   5,   5,   0, -20, -40,
+        -50, -40, -30, -30, -30, -30, -40, -50
+    },
+    { // Bishop
+        -20, -10, -10, -10, -10, -10, -10, -20,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -10,   0,   5,  10,  10,   5,   0, -10,
+        -10,   5,   5,  10,  10,   5,   5, -10,
+        -10,   0,  10,  10,  10,  10,   0, -10,
+        -10,  10,  10,  10,  10,  10,  10, -10,
+        -10,   5,   0,   0,   0,   0,   5, -10,
+        -20, -10, -10, -10, -10, -10, -10, -20
+    },
+    { // Rook
+          0,   0,   0,   0,   0,   0,   0,   0,
+          5,  10,  10,  10,  10,  10,  10,   5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+          0,   0,   0,   5,   5,   0,   0,   0
+    },
+    { // Queen
+        -20, -10, -10,  -5,  -5, -10, -10, -20,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -10,   0,   5,   5,   5,   5,   0, -10,
+         -5,   0,   5,   5,   5,   5,   0,  -5,
+          0,   0,   5,   5,   5,   5,   0,  -5,
+        -10,   5,   5,   5,   5,   5,   0, -10,
+        -10,   0,   5,   0,   0,   0,   0, -10,
+        -20, -10, -10,  -5,  -5, -10, -10, -20
+    },
+    { // King
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -20, -30, -30, -40, -40, -30, -30, -20,
+        -10, -20, -20, -20, -20, -20, -20, -10,
+         20,  20,   0,   0,   0,   0,  20,  20,
+         20,  30,  10,   0,   0,  10,  30,  20
+    }
+};
+
+const int KNIGHT_JUMPS[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+const int SLIDER_DIRECTIONS[8][2] = {{1, 0}, {0, 1}, {-1, 0}, {0, -1}, {1, 1}, {-1, 1}, {-1, -1}, {1, -1}};
+
+inline int pieceSquareValue(PieceType type, Color color, int square) {
+    return PIECE_SQUARE_TABLES[type][color == WHITE ? square : square ^ 56];
+}
+
+// The same score computed piece by piece through the board, the reference for evaluateBatch()
+inline int evaluatePosition(const ChessBoard& board) {
+    int score = 0;
+    for (int square = 0; square < 64; ++square) {
+        Piece* piece = board.getPiece(square);
+        if (!piece) continue;
+
+        PieceType type = piece->type();
+        Color color = piece->getColor();
+        int x = fileOf(square), y = rowOf(square);
+
+        int mobility = 0;
+        if (type == KNIGHT) {
+            for (const int* jump : KNIGHT_JUMPS) {
+                int tx = x + jump[0], ty = y + jump[1];
+                if (tx < 0 || tx > 7 || ty < 0 || ty > 7) continue;
+                Piece* target = board.getPiece(squareIndex(tx, ty));
+                if (!target || target->getColor() != color) ++mobility;
+            }
+        } else if (type == BISHOP || type == ROOK || type == QUEEN) {
+            int first = type == BISHOP ? 4 : 0;
+            int last = type == ROOK ? 4 : 8;
+            for (int d = first; d < last; ++d) {
+                for (int tx = x + SLIDER_DIRECTIONS[d][0], ty = y + SLIDER_DIRECTIONS[d][1];
+                     tx >= 0 && tx <= 7 && ty >= 0 && ty <= 7;
+                     tx += SLIDER_DIRECTIONS[d][0], ty += SLIDER_DIRECTIONS[d][1]) {
+                    Piece* target = board.getPiece(squareIndex(tx, ty));
+                    if (!target || target->getColor() != color) ++mobility;
+                    if (target) break;
+                }
+            }
+        }
+
+        int value = (int)(piece->value() * 100) + pieceSquareValue(type, color, square)
+                  + mobility * MOBILITY_WEIGHTS[type];
+        score += color == WHITE ? value : -value;
+    }
+    return board.getSideToMove() == WHITE ? score : -score;
+}
+
+// The tables in the form the kernels use them
+struct BatchTables {
+    int64_t pieceBase[6]; // material plus the smallest entry of the piece-square table
+    int planeCount[6];
+    uint64_t planes[2][6][8];
+
+    BatchTables() {
+        for (int t = PAWN; t <= KING; ++t) {
+            int low = PIECE_SQUARE_TABLES[t][0], high = low;
+            for (int square = 0; square < 64; ++square) {
+                low = std::min(low, PIECE_SQUARE_TABLES[t][square]);
+                high = std::max(high, PIECE_SQUARE_TABLES[t][square]);
+            }
+            pieceBase[t] = (int)(pieceTypeValue((PieceType)t) * 100) + low;
+            planeCount[t] = 0;
+            while ((high - low) >> planeCount[t]) ++planeCount[t];
+
+            for (int c = WHITE; c <= BLACK; ++c) {
+                for (int b = 0; b < 8; ++b) {
+                    planes[c][t][b] = 0;
+                    for (int square = 0; square < 64; ++square) {
+                        if (((pieceSquareValue((PieceType)t, (Color)c, square) - low) >> b) & 1) {
+                            planes[c][t][b] |= 1ULL << square;
+                        }
+                    }
+                }
+            }
+        }
+    }
+};
+
+const BatchTables BATCH_TABLES;
+
+// Squares a piece may not wrap around from when moving dx files
+inline uint64_t fileWrapMask(int dx) {
+    const uint64_t fileA = 0x0101010101010101ULL;
+    switch (dx) {
+        case 1:  return ~fileA;
+        case 2:  return ~(fileA | fileA << 1);
+        case -1: return ~(fileA << 7);
+        case -2: return ~(fileA << 7 | fileA << 6);
+        default: return ~0ULL;
+    }
+}
+
+// N positions in structure-of-arrays form: planes[color][type][i] is the bitboard of those pieces
+// in position i
+class PositionBatch {
+private:
+    std::vector<uint64_t> planes[2][6];
+    std::vector<uint8_t> sides;
+
+public:
+    size_t size() const {
+        return sides.size();
+    }
+
+    const uint64_t* plane(Color color, PieceType type) const {
+        return planes[color][type].data();
+    }
+
+    Color side(size_t index) const {
+        return (Color)sides[index];
+    }
+
+    void reserve(size_t count) {
+        for (auto& colorPlanes : planes) {
+            for (std::vector<uint64_t>& plane : colorPlanes) plane.reserve(count);
+        }
+        sides.reserve(count);
+    }
+
+    void clear() {
+        for (auto& colorPlanes : planes) {
+            for (std::vector<uint64_t>& plane : colorPlanes) plane.clear();
+        }
+        sides.clear();
+    }
+
+    void add(const ChessBoard& board) {
+        uint64_t bits[2][6] = {};
+        for (int square = 0; square < 64; ++square) {
+            Piece* piece = board.getPiece(square);
+            if (piece) bits[piece->getColor()][piece->type()] |= 1ULL << square;
+        }
+        push(bits, board.getSideToMove());
+    }
+
+    // Reads the placement and side to move of a FEN and ignores the rest;
+    // returns false and adds nothing on malformed input
+    bool addFEN(const std::string& fen) {
+        uint64_t bits[2][6] = {};
+        size_t i = 0;
+        int x = 0, y = 0;
+        for (; i < fen.size() && fen[i] != ' '; ++i) {
+            char c = fen[i];
+            if (c == '/') {
+                if (x != 8 || ++y > 7) return false;
+                x = 0;
+            } else if (c >= '1' && c <= '8') {
+                x += c - '0';
+                if (x > 8) return false;
+            } else {
+                PieceType type;
+                switch (tolower(c)) {
+                    case 'p': type = PAWN; break;
+                    case 'n': type = KNIGHT; break;
+                    case 'b': type = BISHOP; break;
+                    case 'r': type = ROOK; break;
+                    case 'q': type = QUEEN; break;
+                    case 'k': type = KING; break;
+                    default: return false;
+                }
+                if (x > 7) return false;
+                bits[isupper(c) ? WHITE : BLACK][type] |= 1ULL << squareIndex(x++, y);
+            }
+        }
+        if (x != 8 || y != 7 || i + 1 >= fen.size() || (fen[i + 1] != 'w' && fen[i + 1] != 'b')) {
+            return false;
+        }
+        push(bits, fen[i + 1] == 'w' ? WHITE : BLACK);
+        return true;
+    }
+
+private:
+    void push(const uint64_t bits[2][6], Color side) {
+        for (int c = WHITE; c <= BLACK; ++c) {
+            for (int t = PAWN; t <= KING; ++t) planes[c][t].push_back(bits[c][t]);
+        }
+        sides.push_back(side);
+    }
+};
+
+// The kernel is written once in batchkernel.cpp against a small set of lane operations and
+// compiled three times: one position at a time with plain integers, four with AVX2 and eight
+// with AVX-512.
+
+namespace batch_scalar {
+struct Ops {
+    typedef uint64_t V;
+    static const int LANES = 1;
+
+    static V load(const uint64_t* p) { return *p; }
+    static void store(int64_t* p, V v) { *p = (int64_t)v; }
+    static V set1(uint64_t x) { return x; }
+    static V bitAnd(V a, V b) { return a & b; }
+    static V bitOr(V a, V b) { return a | b; }
+    static V bitAndNot(V a, V b) { return a & ~b; }
+    static V shiftLeft(V a, int n) { return a << n; }
+    static V shiftRight(V a, int n) { return a >> n; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    static V multiply(V a, int64_t factor) { return (V)((int64_t)a * factor); }
+    static V popcount(V a) { return __builtin_popcountll(a); }
+};
+
+#include "batchkernel.cpp"
+}
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+namespace batch_avx2 {
+struct Ops {
+    typedef __m256i V;
+    static const int LANES = 4;
+
+    static V load(const uint64_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+    static void store(int64_t* p, V v) { _mm256_storeu_si256((__m256i*)p, v); }
+    static V set1(uint64_t x) { return _mm256_set1_epi64x(x); }
+    static V bitAnd(V a, V b) { return _mm256_and_si256(a, b); }
+    static V bitOr(V a, V b) { return _mm256_or_si256(a, b); }
+    static V bitAndNot(V a, V b) { return _mm256_andnot_si256(b, a); }
+    static V shiftLeft(V a, int n) { return _mm256_slli_epi64(a, n); }
+    static V shiftRight(V a, int n) { return _mm256_srli_epi64(a, n); }
+    static V add(V a, V b) { return _mm256_add_epi64(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_epi64(a, b); }
+    // Signed 32 x 32 -> 64 bit; counts and partial scores always fit in 32 bits
+    static V multiply(V a, int64_t factor) { return _mm256_mul_epi32(a, _mm256_set1_epi64x(factor)); }
+
+    // Per-nibble lookup with vpshufb, then the bytes of each lane summed with vpsadbw
+    static V popcount(V a) {
+        const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                               0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low = _mm256_set1_epi8(0x0f);
+        __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(table, _mm256_and_si256(a, low)),
+                                         _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi64(a, 4), low)));
+        return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+    }
+};
+
+#include "batchkernel.cpp"
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512vpopcntdq")
+namespace batch_avx512 {
+struct Ops {
+    typedef __m512i V;
+    static const int LANES = 8;
+
+    static V load(const uint64_t* p) { return _mm512_loadu_si512(p); }
+    static void store(int64_t* p, V v) { _mm512_storeu_si512(p, v); }
+    static V set1(uint64_t x) { return _mm512_set1_epi64(x); }
+    static V bitAnd(V a, V b) { return _mm512_and_si512(a, b); }
+    static V bitOr(V a, V b) { return _mm512_or_si512(a, b); }
+    static V bitAndNot(V a, V b) { return _mm512_andnot_si512(b, a); }
+    static V shiftLeft(V a, int n) { return _mm512_slli_epi64(a, n); }
+    static V shiftRight(V a, int n) { return _mm512_srli_epi64(a, n); }
+    static V add(V a, V b) { return _mm512_add_epi64(a, b); }
+    static V sub(V a, V b) { return _mm512_sub_epi64(a, b); }
+    static V multiply(V a, int64_t factor) { return _mm512_mul_epi32(a, _mm512_set1_epi64(factor)); }
+    static V popcount(V a) { return _mm512_popcnt_epi64(a); }
+};
+
+#include "batchkernel.cpp"
+}
+#pragma GCC pop_options
+
+enum BatchKernel {
+    KERNEL_SCALAR,
+    KERNEL_AVX2,
+    KERNEL_AVX512
+};
+
+inline const char* kernelName(BatchKernel kernel) {
+    switch (kernel) {
+        case KERNEL_AVX2:   return "avx2";
+        case KERNEL_AVX512: return "avx512";
+        default:            return "scalar";
+    }
+}
+
+inline bool kernelSupported(BatchKernel kernel) {
+    switch (kernel) {
+        case KERNEL_AVX2:   return __builtin_cpu_supports("avx2");
+        case KERNEL_AVX512: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq");
+        default:            return true;
+    }
+}
+
+inline BatchKernel bestKernel() {
+    if (kernelSupported(KERNEL_AVX512)) return KERNEL_AVX512;
+    if (kernelSupported(KERNEL_AVX2)) return KERNEL_AVX2;
+    return KERNEL_SCALAR;
+}
+
+// scores[i] receives the score of position i, as evaluatePosition() would compute it
+inline void evaluateBatch(const PositionBatch& batch, int32_t* scores, BatchKernel kernel = bestKernel()) {
+    size_t done = 0;
+    if (kernel == KERNEL_AVX512) {
+        done = batch_avx512::evaluateBlocks(batch, 0, scores);
+    } else if (kernel == KERNEL_AVX2) {
+        done = batch_avx2::evaluateBlocks(batch, 0, scores);
+    }
+    batch_scalar::evaluateBlocks(batch, done, scores);
+}
@@ -0,0 +1,77 @@
+// Body of the batch evaluation kernel, included by batcheval.cpp once per instruction set inside
+// a namespace that defines Ops. Every V holds one bitboard (or one 64-bit number) per position.
+
+typedef Ops::V V;
+
+inline V shift(V a, int step) {
+    return step > 0 ? Ops::shiftLeft(a, step) : Ops::shiftRight(a, -step);
+}
+
+// Squares attacked in one direction by every piece of `pieces`, up to and including the first
+// occupied square. Kogge-Stone fill: the set grows by 1, 2 and then 4 steps through empty squares.
+inline V slide(V pieces, V empty, int step, V wrap) {
+    V propagate = Ops::bitAnd(empty, wrap);
+    pieces = Ops::bitOr(pieces, Ops::bitAnd(propagate, shift(pieces, step)));
+    propagate = Ops::bitAnd(propagate, shift(propagate, step));
+    pieces = Ops::bitOr(pieces, Ops::bitAnd(propagate, shift(pieces, 2 * step)));
+    propagate = Ops::bitAnd(propagate, shift(propagate, 2 * step));
+    pieces = Ops::bitOr(pieces, Ops::bitAnd(propagate, shift(pieces, 4 * step)));
+    return Ops::bitAnd(shift(pieces, step), wrap);
+}
+
+// Evaluates positions first, first + LANES, ... while a whole block fits and returns where it
+// stopped
+inline size_t evaluateBlocks(const PositionBatch& batch, size_t first, int32_t* scores) {
+    size_t i = first;
+    for (; i + Ops::LANES <= batch.size(); i += Ops::LANES) {
+        V pieces[2][6], own[2];
+        for (int c = WHITE; c <= BLACK; ++c) {
+            own[c] = Ops::set1(0);
+            for (int t = PAWN; t <= KING; ++t) {
+                pieces[c][t] = Ops::load(batch.plane((Color)c, (PieceType)t) + i);
+                own[c] = Ops::bitOr(own[c], pieces[c][t]);
+            }
+        }
+        V empty = Ops::bitAndNot(Ops::set1(~0ULL), Ops::bitOr(own[WHITE], own[BLACK]));
+
+        V total[2];
+        for (int c = WHITE; c <= BLACK; ++c) {
+            V score = Ops::set1(0);
+            for (int t = PAWN; t <= KING; ++t) {
+                V set = pieces[c][t];
+                score = Ops::add(score, Ops::multiply(Ops::popcount(set), BATCH_TABLES.pieceBase[t]));
+                for (int b = 0; b < BATCH_TABLES.planeCount[t]; ++b) {
+                    V onPlane = Ops::popcount(Ops::bitAnd(set, Ops::set1(BATCH_TABLES.planes[c][t][b])));
+                    score = Ops::add(score, Ops::shiftLeft(onPlane, b));
+                }
+            }
+
+            V knightMoves = Ops::set1(0);
+            for (const int* jump : KNIGHT_JUMPS) {
+                V targets = Ops::bitAnd(shift(pieces[c][KNIGHT], jump[1] * 8 + jump[0]), Ops::set1(fileWrapMask(jump[0])));
+                knightMoves = Ops::add(knightMoves, Ops::popcount(Ops::bitAndNot(targets, own[c])));
+            }
+            score = Ops::add(score, Ops::multiply(knightMoves, MOBILITY_WEIGHTS[KNIGHT]));
+
+            for (int t = BISHOP; t <= QUEEN; ++t) {
+                int firstDirection = t == BISHOP ? 4 : 0;
+                int lastDirection = t == ROOK ? 4 : 8;
+                V moves = Ops::set1(0);
+                for (int d = firstDirection; d < lastDirection; ++d) {
+                    int dx = SLIDER_DIRECTIONS[d][0], dy = SLIDER_DIRECTIONS[d][1];
+                    V targets = slide(pieces[c][t], empty, dy * 8 + dx, Ops::set1(fileWrapMask(dx)));
+                    moves = Ops::add(moves, Ops::popcount(Ops::bitAndNot(targets, own[c])));
+                }
+                score = Ops::add(score, Ops::multiply(moves, MOBILITY_WEIGHTS[t]));
+            }
+            total[c] = score;
+        }
+
+        int64_t lanes[Ops::LANES];
+        Ops::store(lanes, Ops::sub(total[WHITE], total[BLACK]));
+        for (int lane = 0; lane < Ops::LANES; ++lane) {
+            scores[i + lane] = (int32_t)(batch.side(i + lane) == WHITE ? lanes[lane] : -lanes[lane]);
+        }
+    }
+    return i;
+}
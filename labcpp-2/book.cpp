@@ -0,0 +1,207 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "chessboard.cpp"
+
+// Polyglot .bin entries are 16 bytes, big-endian: key, move, weight, learn
+const size_t BOOK_ENTRY_SIZE = 16;
+
+struct BookEntry {
+    uint64_t key;
+    uint16_t move;
+    uint16_t weight;
+    uint32_t learn;
+};
+
+inline uint64_t readBigEndian(const unsigned char* bytes, int count) {
+    uint64_t value = 0;
+    for (int i = 0; i < count; ++i) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+inline void writeBigEndian(unsigned char* bytes, uint64_t value, int count) {
+    for (int i = count - 1; i >= 0; --i) {
+        bytes[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+// Polyglot move: to file, to row, from file, from row (3 bits each, row 0 is rank 1), then promotion.
+// Castling is written as the king capturing its own rook.
+inline uint16_t toPolyglotMove(const Move& move) {
+    int to = move.to;
+    if (move.flags & CASTLING) {
+        to = move.to > move.from ? move.from + 3 : move.from - 4;
+    }
+    int promotion = move.promotion == NO_PIECE_TYPE ? 0 : move.promotion;
+    return fileOf(to)
+         | (BOARD_SIZE - 1 - rowOf(to)) << 3
+         | fileOf(move.from) << 6
+         | (BOARD_SIZE - 1 - rowOf(move.from)) << 9
+         | promotion << 12;
+}
+
+// Read-only, zero-copy view of a Polyglot book. Nothing is mutated after open(),
+// so one instance can be shared by every search thread.
+//
+// Keys come from ChessBoard::getHash(), which uses the Polyglot Random64 table, so books
+// written by other tools can be used as they are.
+class PolyglotBook {
+private:
+    const unsigned char* data;
+    size_t mappedSize;
+    size_t count;
+    bool opened;
+
+public:
+    PolyglotBook() : data(nullptr), mappedSize(0), count(0), opened(false) {}
+
+    PolyglotBook(const PolyglotBook&) = delete;
+    PolyglotBook& operator=(const PolyglotBook&) = delete;
+
+    ~PolyglotBook() {
+        close();
+    }
+
+    bool open(const std::string& path) {
+        close();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size % BOOK_ENTRY_SIZE != 0) {
+            ::close(fd);
+            return false;
+        }
+        if (info.st_size == 0) {
+            // A valid book without moves; mmap cannot map zero bytes
+            ::close(fd);
+            opened = true;
+            return true;
+        }
+
+        void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+        madvise(mapped, info.st_size, MADV_RANDOM);
+
+        data = static_cast<const unsigned char*>(mapped);
+        mappedSize = info.st_size;
+        count = mappedSize / BOOK_ENTRY_SIZE;
+        opened = true;
+        return true;
+    }
+
+    void close() {
+        if (data) {
+            munmap(const_cast<unsigned char*>(data), mappedSize);
+        }
+        data = nullptr;
+        mappedSize = 0;
+        count = 0;
+        opened = false;
+    }
+
+    bool isOpen() const {
+        return opened;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    uint64_t keyAt(size_t index) const {
+        return readBigEndian(data + index * BOOK_ENTRY_SIZE, 8);
+    }
+
+    BookEntry entry(size_t index) const {
+        const unsigned char* bytes = data + index * BOOK_ENTRY_SIZE;
+        return BookEntry{readBigEndian(bytes, 8), (uint16_t)readBigEndian(bytes + 8, 2),
+                         (uint16_t)readBigEndian(bytes + 10, 2), (uint32_t)readBigEndian(bytes + 12, 4)};
+    }
+
+    // Index of the first entry with this key (lower bound), size() if absent
+    size_t find(uint64_t key) const {
+        size_t low = 0, high = count;
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (keyAt(middle) < key) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low < count && keyAt(low) == key ? low : count;
+    }
+
+    // Fills legal book moves for the position and their weights, returns how many were found
+    int probe(ChessBoard& board, Move* moves, uint16_t* weights, int capacity) const {
+        uint64_t key = board.getHash();
+        size_t index = find(key);
+        if (index == count) {
+            return 0;
+        }
+
+        MoveList legal;
+        board.generateMoves(legal);
+
+        int found = 0;
+        for (; index < count && found < capacity && keyAt(index) == key; ++index) {
+            BookEntry bookEntry = entry(index);
+            for (int i = 0; i < legal.size; ++i) {
+                if (toPolyglotMove(legal[i]) == bookEntry.move) {
+                    moves[found] = legal[i];
+                    weights[found] = bookEntry.weight;
+                    ++found;
+                    break;
+                }
+            }
+        }
+        return found;
+    }
+
+    // Picks a book move with probability proportional to its weight.
+    // random is any uniformly distributed value supplied by the caller, so each thread keeps its own generator.
+    bool pickMove(ChessBoard& board, uint64_t random, Move& move) const {
+        Move moves[MAX_MOVES];
+        uint16_t weights[MAX_MOVES];
+        int found = probe(board, moves, weights, MAX_MOVES);
+
+        uint64_t total = 0;
+        for (int i = 0; i < found; ++i) {
+            total += weights[i];
+        }
+        if (found == 0) {
+            return false;
+        }
+        if (total == 0) {
+            move = moves[random % found];
+            return true;
+        }
+
+        uint64_t target = random % total;
+        for (int i = 0; i < found; ++i) {
+            if (target < weights[i]) {
+                move = moves[i];
+                return true;
+            }
+            target -= weights[i];
+        }
+        move = moves[found - 1];
+        return true;
+    }
+};
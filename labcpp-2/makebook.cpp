@@ -0,0 +1,183 @@
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <random>
+
+#include "book.cpp"
+
+// Builds a Polyglot book from a text file. Each line uses the arguments of the UCI "position" command:
+//     startpos moves e2e4 e7e5 g1f3
+//     fen <fen> moves <move>
+// Every position along the line counts one vote for the move played from it. A line that does not
+// parse adds no votes at all.
+//
+// Usage: makebook <input.txt> <output.bin> [max plies per line]
+//        makebook --probe <book.bin> [fen]
+
+struct BookMove {
+    uint64_t key;
+    uint16_t move;
+    uint32_t count;
+};
+
+bool readLine(ChessBoard& board, const std::string& line, int maxPly, std::vector<BookMove>& votes) {
+    std::istringstream in(line);
+    std::string token;
+    if (!(in >> token)) {
+        return true;
+    }
+
+    if (token == "startpos") {
+        board.setFEN(START_FEN);
+        if (in >> token && token != "moves") {
+            return false;
+        }
+    } else if (token == "fen") {
+        std::string fen;
+        while (in >> token && token != "moves") {
+            fen += (fen.empty() ? "" : " ") + token;
+        }
+        if (!board.setFEN(fen)) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    std::vector<BookMove> lineVotes;
+    int ply = 0;
+    while (ply < maxPly && in >> token) {
+        Move move;
+        if (!board.parseMove(token, move)) {
+            return false;
+        }
+        lineVotes.push_back(BookMove{board.getHash(), toPolyglotMove(move), 1});
+        board.makeMove(move);
+        ++ply;
+        if (board.getPly() == MAX_PLY) {
+            board.clearHistory();
+        }
+    }
+    votes.insert(votes.end(), lineVotes.begin(), lineVotes.end());
+    return true;
+}
+
+// Sorts by key, merges duplicate moves and squeezes the counts of each position into 16 bits
+std::vector<BookMove> normalize(std::vector<BookMove>& votes) {
+    std::sort(votes.begin(), votes.end(), [](const BookMove& a, const BookMove& b) {
+        return a.key != b.key ? a.key < b.key : a.move < b.move;
+    });
+
+    std::vector<BookMove> merged;
+    for (const BookMove& vote : votes) {
+        if (!merged.empty() && merged.back().key == vote.key && merged.back().move == vote.move) {
+            merged.back().count += vote.count;
+        } else {
+            merged.push_back(vote);
+        }
+    }
+
+    for (size_t begin = 0, end; begin < merged.size(); begin = end) {
+        uint32_t maxCount = 0;
+        for (end = begin; end < merged.size() && merged[end].key == merged[begin].key; ++end) {
+            maxCount = std::max(maxCount, merged[end].count);
+        }
+        if (maxCount > UINT16_MAX) {
+            for (size_t i = begin; i < end; ++i) {
+                merged[i].count = std::max<uint64_t>(1, (uint64_t)merged[i].count * UINT16_MAX / maxCount);
+            }
+        }
+        // Polyglot convention: the most played move of a position comes first
+        std::stable_sort(merged.begin() + begin, merged.begin() + end, [](const BookMove& a, const BookMove& b) {
+            return a.count > b.count;
+        });
+    }
+
+    return merged;
+}
+
+bool writeBook(const std::string& path, const std::vector<BookMove>& entries) {
+    std::ofstream out(path, std::ios::binary);
+    unsigned char bytes[BOOK_ENTRY_SIZE];
+    for (const BookMove& entry : entries) {
+        writeBigEndian(bytes, entry.key, 8);
+        writeBigEndian(bytes + 8, entry.move, 2);
+        writeBigEndian(bytes + 10, entry.count, 2);
+        writeBigEndian(bytes + 12, 0, 4);
+        out.write(reinterpret_cast<const char*>(bytes), BOOK_ENTRY_SIZE);
+    }
+    return (bool)out;
+}
+
+int probe(const std::string& path, const std::string& fen) {
+    PolyglotBook book;
+    if (!book.open(path)) {
+        std::cerr << "Cannot open book " << path << std::endl;
+        return 1;
+    }
+
+    ChessBoard board;
+    if (!board.setFEN(fen)) {
+        std::cerr << "Invalid FEN: " << fen << std::endl;
+        return 1;
+    }
+
+    Move moves[MAX_MOVES];
+    uint16_t weights[MAX_MOVES];
+    int found = book.probe(board, moves, weights, MAX_MOVES);
+    for (int i = 0; i < found; ++i) {
+        std::cout << toUCI(moves[i]) << " " << weights[i] << std::endl;
+    }
+
+    Move move;
+    std::mt19937_64 random(std::random_device{}());
+    if (book.pickMove(board, random(), move)) {
+        std::cout << "Picked: " << toUCI(move) << std::endl;
+    } else {
+        std::cout << "Position is not in the book" << std::endl;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 3 && std::string(argv[1]) == "--probe") {
+        std::string fen;
+        for (int i = 3; i < argc; ++i) {
+            fen += (i > 3 ? " " : "") + std::string(argv[i]);
+        }
+        return probe(argv[2], fen.empty() ? START_FEN : fen);
+    }
+
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <input.txt> <output.bin> [max plies per line]\n"
+                  << "       " << argv[0] << " --probe <book.bin> [fen]" << std::endl;
+        return 1;
+    }
+
+    std::ifstream input(argv[1]);
+    if (!input) {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+    int maxPly = argc > 3 ? std::atoi(argv[3]) : 40;
+
+    ChessBoard board;
+    std::vector<BookMove> votes;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(input, line)) {
+        ++lineNumber;
+        if (!readLine(board, line, maxPly, votes)) {
+            std::cerr << "Skipping line " << lineNumber << ": " << line << std::endl;
+        }
+    }
+
+    std::vector<BookMove> entries = normalize(votes);
+    if (!writeBook(argv[2], entries)) {
+        std::cerr << "Cannot write " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::cout << lineNumber << " lines, " << votes.size() << " moves, " << entries.size() << " book entries" << std::endl;
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+#include "chessboard.cpp"
+
+// Counts every heap allocation so we can prove the tree walk itself never allocates
+static unsigned long long allocationCount = 0;
+
+void* operator new(std::size_t size) {
+    ++allocationCount;
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+struct PerftCase {
+    const char* name;
+    const char* fen;
+    int depth;
+    unsigned long long expected;
+};
+
+// Reference node counts from the Chess Programming Wiki perft results page
+const PerftCase PERFT_CASES[] = {
+    {"start", START_FEN, 5, 4865609},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603},
+    {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624},
+    {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 422333},
+    {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487},
+};
+
+struct KeyCase {
+    const char* moves;
+    uint64_t expected;
+};
+
+// Keys from the Polyglot book format specification, reached from the start position
+const KeyCase KEY_CASES[] = {
+    {"", 0x463b96181691fc9cull},
+    {"e2e4", 0x823c9b50fd114196ull},
+    {"e2e4 d7d5", 0x0756b94461c50fb0ull},
+    {"e2e4 d7d5 e4e5", 0x662fafb965db29d4ull},
+    {"e2e4 d7d5 e4e5 f7f5", 0x22a48b5a8e47ff78ull},
+    {"e2e4 d7d5 e4e5 f7f5 e1e2", 0x652a607ca3f242c1ull},
+    {"e2e4 d7d5 e4e5 f7f5 e1e2 e8f7", 0x00fdd303c946bdd9ull},
+    {"a2a4 b7b5 h2h4 b5b4 c2c4", 0x3c8123ea7b067637ull},
+    {"a2a4 b7b5 h2h4 b5b4 c2c4 b4c3 a1a3", 0x5c3f9b829b279560ull},
+};
+
+// Checks both the incremental key after each move sequence and the key setFEN computes from scratch
+bool checkKeys() {
+    bool ok = true;
+    for (const KeyCase& test : KEY_CASES) {
+        ChessBoard board;
+        board.setFEN(START_FEN);
+        std::istringstream moves(test.moves);
+        std::string token;
+        Move move;
+        while (moves >> token && board.parseMove(token, move)) {
+            board.makeMove(move);
+        }
+        ChessBoard fromFEN;
+        fromFEN.setFEN(board.toFEN());
+        if (board.getHash() != test.expected || fromFEN.getHash() != test.expected) {
+            std::cout << "Polyglot key after \"" << test.moves << "\": " << std::hex << board.getHash()
+                      << ", expected " << test.expected << std::dec << " FAILED" << std::endl;
+            ok = false;
+        }
+    }
+    std::cout << "Polyglot keys: " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok;
+}
+
+unsigned long long perft(ChessBoard& board, int depth) {
+    MoveList list;
+    board.generateMoves(list);
+    if (depth == 1) {
+        return list.size;
+    }
+
+    unsigned long long nodes = 0;
+    for (int i = 0; i < list.size; ++i) {
+        board.makeMove(list[i]);
+        nodes += perft(board, depth - 1);
+        board.unmakeMove();
+    }
+    return nodes;
+}
+
+int main(int argc, char* argv[]) {
+    // Optional: perft <depth> <fen...> to run a single position
+    if (argc > 2) {
+        std::string fen;
+        for (int i = 2; i < argc; ++i) {
+            fen += (i > 2 ? " " : "") + std::string(argv[i]);
+        }
+        ChessBoard board;
+        if (!board.setFEN(fen)) {
+            std::cerr << "Invalid FEN: " << fen << std::endl;
+            return 1;
+        }
+
+        MoveList list;
+        board.generateMoves(list);
+        unsigned long long total = 0;
+        int depth = std::atoi(argv[1]);
+        for (int i = 0; i < list.size; ++i) {
+            board.makeMove(list[i]);
+            unsigned long long nodes = depth > 1 ? perft(board, depth - 1) : 1;
+            board.unmakeMove();
+            std::cout << toUCI(list[i]) << ": " << nodes << std::endl;
+            total += nodes;
+        }
+        std::cout << "\nNodes: " << total << std::endl;
+        return 0;
+    }
+
+    bool ok = checkKeys();
+    for (const PerftCase& test : PERFT_CASES) {
+        ChessBoard board;
+        board.setFEN(test.fen);
+        uint64_t hashBefore = board.getHash();
+
+        unsigned long long allocationsBefore = allocationCount;
+        auto start = std::chrono::steady_clock::now();
+        unsigned long long nodes = perft(board, test.depth);
+        auto finish = std::chrono::steady_clock::now();
+        unsigned long long allocations = allocationCount - allocationsBefore;
+
+        double seconds = std::chrono::duration<double>(finish - start).count();
+        bool passed = nodes == test.expected && allocations == 0
+                      && board.getHash() == hashBefore && board.toFEN() == test.fen;
+        ok = ok && passed;
+
+        std::cout << test.name << " depth " << test.depth << ": " << nodes << " nodes"
+                  << " in " << seconds << " s (" << (unsigned long long)(nodes / seconds) << " nps), "
+                  << allocations << " allocations " << (passed ? "OK" : "FAILED") << std::endl;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "chessboard.cpp"
+
+// Streaming PGN tokenizer. It works on any character range (usually a memory-mapped file)
+// and never copies: token text points back into the input.
+
+enum PgnTokenType {
+    PGN_TAG,    // [Name "Value"]
+    PGN_MOVE,   // SAN move, annotations stripped
+    PGN_RESULT, // 1-0, 0-1, 1/2-1/2, *
+    PGN_END
+};
+
+struct PgnToken {
+    PgnTokenType type;
+    std::string_view text;  // tag name, move or result
+    std::string_view value; // tag value
+    const char* position;   // where the token starts in the input
+};
+
+enum GameResult {
+    WHITE_WINS,
+    BLACK_WINS,
+    DRAW,
+    UNKNOWN_RESULT
+};
+
+inline GameResult parseResult(std::string_view text) {
+    if (text == "1-0") return WHITE_WINS;
+    if (text == "0-1") return BLACK_WINS;
+    if (text == "1/2-1/2") return DRAW;
+    return UNKNOWN_RESULT;
+}
+
+class PgnTokenizer {
+private:
+    const char* begin;
+    const char* current;
+    const char* end;
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '.';
+    }
+
+    void skipTo(char terminator) {
+        while (current < end && *current != terminator) ++current;
+        if (current < end) ++current;
+    }
+
+    void skipVariation() {
+        int depth = 0;
+        while (current < end) {
+            char c = *current++;
+            if (c == '(') {
+                ++depth;
+            } else if (c == ')') {
+                if (--depth == 0) return;
+            } else if (c == '{') {
+                skipTo('}');
+            }
+        }
+    }
+
+    bool readTag(PgnToken& token) {
+        const char* start = current++;
+        while (current < end && *current == ' ') ++current;
+        const char* name = current;
+        while (current < end && *current != ' ' && *current != '"' && *current != ']') ++current;
+        token.text = std::string_view(name, current - name);
+
+        while (current < end && *current != '"' && *current != ']') ++current;
+        const char* value = current;
+        if (current < end && *current == '"') {
+            value = ++current;
+            while (current < end && *current != '"') {
+                if (*current == '\\' && current + 1 < end) ++current;
+                ++current;
+            }
+            token.value = std::string_view(value, current - value);
+        } else {
+            token.value = std::string_view();
+        }
+        skipTo(']');
+
+        token.type = PGN_TAG;
+        token.position = start;
+        return true;
+    }
+
+public:
+    PgnTokenizer(const char* begin, const char* end) : begin(begin), current(begin), end(end) {}
+
+    const char* position() const {
+        return current;
+    }
+
+    bool next(PgnToken& token) {
+        while (current < end) {
+            char c = *current;
+            if (isSpace(c)) {
+                ++current;
+            } else if (c == '{') {
+                skipTo('}');
+            } else if (c == ';' || (c == '%' && (current == begin || current[-1] == '\n'))) {
+                skipTo('\n');
+            } else if (c == '(') {
+                skipVariation();
+            } else if (c == ')') {
+                ++current;
+            } else if (c == '$') {
+                ++current;
+                while (current < end && *current >= '0' && *current <= '9') ++current;
+            } else if (c == '[') {
+                return readTag(token);
+            } else {
+                const char* start = current;
+                while (current < end && !isSpace(*current) && *current != '{' && *current != '('
+                       && *current != ')' && *current != ';' && *current != '[') {
+                    ++current;
+                }
+                std::string_view word(start, current - start);
+
+                // Move numbers: "12" followed by dots, which isSpace already ate
+                if (word[0] >= '0' && word[0] <= '9' && word.find_first_not_of("0123456789") == std::string_view::npos) {
+                    continue;
+                }
+                token.position = start;
+                if (word == "1-0" || word == "0-1" || word == "1/2-1/2" || word == "*") {
+                    token.type = PGN_RESULT;
+                    token.text = word;
+                    return true;
+                }
+                if (word == "--") {
+                    continue;
+                }
+
+                // Strip check marks and annotation glyphs such as "+", "#", "!?"
+                size_t length = word.find_last_not_of("+#!?");
+                if (length == std::string_view::npos) {
+                    continue;
+                }
+                token.type = PGN_MOVE;
+                token.text = word.substr(0, length + 1);
+                return true;
+            }
+        }
+        token.type = PGN_END;
+        token.position = end;
+        return false;
+    }
+};
+
+inline PieceType sanPieceType(char c) {
+    switch (c) {
+        case 'N': return KNIGHT;
+        case 'B': return BISHOP;
+        case 'R': return ROOK;
+        case 'Q': return QUEEN;
+        case 'K': return KING;
+        default:  return NO_PIECE_TYPE;
+    }
+}
+
+// Decodes a SAN move such as "Nbd7", "exd6", "e8=Q" or "O-O". Candidates are matched among pseudo-legal
+// moves first, so the costly legality check only runs for the few moves that fit the notation.
+inline bool parseSAN(ChessBoard& board, std::string_view san, Move& move) {
+    MoveList list;
+    board.generatePseudoLegalMoves(list);
+
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        bool kingside = san.size() == 3;
+        for (int i = 0; i < list.size; ++i) {
+            if ((list[i].flags & CASTLING) && (list[i].to > list[i].from) == kingside && board.isLegal(list[i])) {
+                move = list[i];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    PieceType piece = PAWN;
+    PieceType promotion = NO_PIECE_TYPE;
+    size_t begin = 0, end = san.size();
+    if (end > 0 && sanPieceType(san[0]) != NO_PIECE_TYPE) {
+        piece = sanPieceType(san[0]);
+        begin = 1;
+    }
+
+    // Promotion: "e8=Q" or "e8Q"
+    if (end > 0 && piece == PAWN && sanPieceType(san[end - 1]) != NO_PIECE_TYPE) {
+        promotion = sanPieceType(san[end - 1]);
+        --end;
+        if (end > 0 && san[end - 1] == '=') --end;
+    }
+    if (end < begin + 2) {
+        return false;
+    }
+
+    char toFile = san[end - 2], toRank = san[end - 1];
+    if (toFile < 'a' || toFile > 'h' || toRank < '1' || toRank > '8') {
+        return false;
+    }
+    int to = squareIndex(toFile - 'a', BOARD_SIZE - (toRank - '0'));
+
+    int fromFile = -1, fromRow = -1;
+    for (size_t i = begin; i < end - 2; ++i) {
+        char c = san[i];
+        if (c >= 'a' && c <= 'h') fromFile = c - 'a';
+        else if (c >= '1' && c <= '8') fromRow = BOARD_SIZE - (c - '0');
+    }
+
+    int matches = 0;
+    for (int i = 0; i < list.size; ++i) {
+        const Move& candidate = list[i];
+        if (candidate.to != to || (candidate.flags & CASTLING)) continue;
+        if (board.getPiece(candidate.from)->type() != piece) continue;
+        if (candidate.promotion != promotion) continue;
+        if (fromFile >= 0 && fileOf(candidate.from) != fromFile) continue;
+        if (fromRow >= 0 && rowOf(candidate.from) != fromRow) continue;
+        if (!board.isLegal(candidate)) continue;
+        move = candidate;
+        ++matches;
+    }
+    return matches == 1;
+}
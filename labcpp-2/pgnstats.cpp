@@ -0,0 +1,358 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pgn.cpp"
+
+// Replays every game of a PGN file and prints aggregate statistics.
+// The file is memory-mapped and cut into fixed-size chunks; worker threads claim chunks one by one
+// and replay the games that start inside them. Every table below has a fixed size, so memory use
+// does not depend on the size of the file.
+//
+// Usage: pgnstats <games.pgn> [threads]
+
+const size_t CHUNK_SIZE = 1 << 20;
+const int OPENING_PLY = 8;
+const int MAX_TRACKED_PLY = 200;
+const size_t OPENING_TABLE_SIZE = 1 << 16;
+
+struct OpeningSlot {
+    uint64_t key;
+    uint64_t count;
+    Move moves[OPENING_PLY];
+};
+
+struct GameStats {
+    uint64_t games = 0;
+    uint64_t invalidGames = 0;
+    uint64_t plies = 0;
+    uint64_t results[UNKNOWN_RESULT + 1] = {};
+
+    double materialSum[MAX_TRACKED_PLY] = {};
+    uint64_t materialCount[MAX_TRACKED_PLY] = {};
+
+    // Open addressing keyed by the position hash after OPENING_PLY plies; once full, new openings go to "other"
+    std::vector<OpeningSlot> openings;
+    size_t openingCount = 0;
+    uint64_t otherOpenings = 0;
+
+    GameStats() : openings(OPENING_TABLE_SIZE, OpeningSlot{0, 0, {}}) {}
+
+    void addOpening(uint64_t key, const Move* moves, uint64_t count) {
+        size_t index = key & (OPENING_TABLE_SIZE - 1);
+        while (openings[index].count != 0 && openings[index].key != key) {
+            index = (index + 1) & (OPENING_TABLE_SIZE - 1);
+        }
+        if (openings[index].count == 0) {
+            if (openingCount >= OPENING_TABLE_SIZE / 2) {
+                otherOpenings += count;
+                return;
+            }
+            ++openingCount;
+            openings[index].key = key;
+            std::copy(moves, moves + OPENING_PLY, openings[index].moves);
+        }
+        openings[index].count += count;
+    }
+
+    void merge(const GameStats& other) {
+        games += other.games;
+        invalidGames += other.invalidGames;
+        plies += other.plies;
+        for (int i = 0; i <= UNKNOWN_RESULT; ++i) {
+            results[i] += other.results[i];
+        }
+        for (int i = 0; i < MAX_TRACKED_PLY; ++i) {
+            materialSum[i] += other.materialSum[i];
+            materialCount[i] += other.materialCount[i];
+        }
+        for (const OpeningSlot& slot : other.openings) {
+            if (slot.count) addOpening(slot.key, slot.moves, slot.count);
+        }
+        otherOpenings += other.otherOpenings;
+    }
+};
+
+// Material of white minus black in pawns, from Piece::value()
+double materialBalance(const ChessBoard& board) {
+    double balance = 0;
+    for (int square = 0; square < BOARD_SIZE * BOARD_SIZE; ++square) {
+        Piece* piece = board.getPiece(square);
+        if (piece) {
+            balance += piece->getColor() == WHITE ? piece->value() : -piece->value();
+        }
+    }
+    return balance;
+}
+
+class GameReplay {
+private:
+    ChessBoard& board;
+    GameStats& stats;
+
+    bool started = false;
+    bool valid = true;
+    int ply = 0;
+    double material = 0;
+    GameResult tagResult = UNKNOWN_RESULT;
+    std::string fen;
+    Move moves[OPENING_PLY];
+    uint64_t openingKey = 0;
+    // Kept until the game ends, so that games that cannot be replayed add nothing to the averages
+    double materialByPly[MAX_TRACKED_PLY];
+
+public:
+    GameReplay(ChessBoard& board, GameStats& stats) : board(board), stats(stats) {}
+
+    bool isOpen() const {
+        return started || !fen.empty() || tagResult != UNKNOWN_RESULT;
+    }
+
+    void tag(std::string_view name, std::string_view value) {
+        if (name == "FEN") {
+            fen = std::string(value);
+        } else if (name == "Result") {
+            tagResult = parseResult(value);
+        }
+    }
+
+    void move(std::string_view san) {
+        if (!started) {
+            started = true;
+            valid = board.setFEN(fen.empty() ? START_FEN : fen);
+            material = materialBalance(board);
+        }
+        if (!valid) return;
+
+        // Before parseSAN(), whose legality check also makes a move
+        if (board.getPly() >= MAX_PLY - 1) {
+            board.clearHistory();
+        }
+        Move move;
+        if (!parseSAN(board, san, move)) {
+            valid = false;
+            return;
+        }
+
+        double captured = 0;
+        if (move.flags & EN_PASSANT) {
+            captured = board.getPiece(squareIndex(fileOf(move.to), rowOf(move.from)))->value();
+        } else if (move.flags & CAPTURE) {
+            captured = board.getPiece(move.to)->value();
+        }
+        Color mover = board.getSideToMove();
+        double moverValue = board.getPiece(move.from)->value();
+
+        board.makeMove(move);
+
+        double gained = captured + board.getPiece(move.to)->value() - moverValue;
+        material += mover == WHITE ? gained : -gained;
+
+        if (ply < OPENING_PLY) {
+            moves[ply] = move;
+        }
+        if (ply < MAX_TRACKED_PLY) {
+            materialByPly[ply] = material;
+        }
+        ++ply;
+        if (ply == OPENING_PLY) {
+            openingKey = board.getHash();
+        }
+    }
+
+    void finish(GameResult result) {
+        if (result == UNKNOWN_RESULT) {
+            result = tagResult;
+        }
+        ++stats.games;
+        if (!valid) {
+            ++stats.invalidGames;
+        } else {
+            ++stats.results[result];
+            stats.plies += ply;
+            for (int i = 0; i < std::min(ply, MAX_TRACKED_PLY); ++i) {
+                stats.materialSum[i] += materialByPly[i];
+                stats.materialCount[i] += 1;
+            }
+            if (ply >= OPENING_PLY) {
+                stats.addOpening(openingKey, moves, 1);
+            }
+        }
+
+        started = false;
+        valid = true;
+        ply = 0;
+        tagResult = UNKNOWN_RESULT;
+        fen.clear();
+    }
+};
+
+// A game starts with its first tag: a '[' at the start of a line that does not follow another tag,
+// whatever the tag is. Returns the first game start in [begin, end), or end if there is none.
+size_t findGameStart(const char* data, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        const char* found = static_cast<const char*>(memchr(data + i, '[', end - i));
+        if (!found) break;
+        i = found - data;
+        if (i > 0 && data[i - 1] != '\n') continue;
+
+        size_t previous = i;
+        while (previous > 0 && (data[previous - 1] == '\n' || data[previous - 1] == '\r'
+                                || data[previous - 1] == ' ' || data[previous - 1] == '\t')) {
+            --previous;
+        }
+        if (previous == 0 || data[previous - 1] != ']') {
+            return i;
+        }
+    }
+    return end;
+}
+
+// Replays the games that start in [begin, end); the last one may run past end
+void processChunk(const char* data, size_t size, size_t begin, size_t end, ChessBoard& board, GameStats& stats) {
+    size_t start = findGameStart(data, begin, end);
+    if (start >= end) return;
+
+    GameReplay game(board, stats);
+    PgnTokenizer tokenizer(data + start, data + size);
+    PgnToken token;
+    bool inTags = false;
+    while (tokenizer.next(token)) {
+        if (token.type == PGN_TAG) {
+            // The first tag after movetext starts the next game
+            if (!inTags) {
+                if (game.isOpen()) game.finish(UNKNOWN_RESULT);
+                if (token.position >= data + end) return;
+                inTags = true;
+            }
+            game.tag(token.text, token.value);
+        } else if (token.type == PGN_MOVE) {
+            inTags = false;
+            game.move(token.text);
+        } else if (token.type == PGN_RESULT) {
+            inTags = false;
+            game.finish(parseResult(token.text));
+        }
+    }
+    if (game.isOpen()) game.finish(UNKNOWN_RESULT);
+}
+
+void printReport(const GameStats& stats, double seconds, size_t bytes) {
+    const char* names[] = {"1-0", "0-1", "1/2-1/2", "*"};
+    uint64_t validGames = stats.games - stats.invalidGames;
+
+    std::cout << "Games: " << stats.games << " (" << stats.invalidGames << " could not be replayed)\n";
+    std::cout << "Plies: " << stats.plies << "\n";
+    std::cout << "Time: " << seconds << " s, " << (uint64_t)(stats.games / seconds) << " games/s, "
+              << bytes / seconds / (1 << 20) << " MB/s\n\n";
+
+    std::cout << "Results:\n";
+    for (int i = 0; i <= UNKNOWN_RESULT; ++i) {
+        std::cout << "  " << names[i] << ": " << stats.results[i];
+        if (validGames) std::cout << " (" << 100.0 * stats.results[i] / validGames << "%)";
+        std::cout << "\n";
+    }
+
+    std::vector<const OpeningSlot*> top;
+    for (const OpeningSlot& slot : stats.openings) {
+        if (slot.count) top.push_back(&slot);
+    }
+    size_t shown = std::min<size_t>(10, top.size());
+    std::partial_sort(top.begin(), top.begin() + shown, top.end(), [](const OpeningSlot* a, const OpeningSlot* b) {
+        return a->count > b->count;
+    });
+    std::cout << "\nMost frequent positions after " << OPENING_PLY << " plies (" << top.size() << " distinct):\n";
+    for (size_t i = 0; i < shown; ++i) {
+        std::cout << "  " << top[i]->count << "  " << std::hex << top[i]->key << std::dec << " ";
+        for (int j = 0; j < OPENING_PLY; ++j) {
+            std::cout << " " << toUCI(top[i]->moves[j]);
+        }
+        std::cout << "\n";
+    }
+    if (stats.otherOpenings) {
+        std::cout << "  " << stats.otherOpenings << "  (did not fit in the table)\n";
+    }
+
+    std::cout << "\nAverage material balance (white - black):\n";
+    for (int ply = 0; ply < MAX_TRACKED_PLY; ply += 10) {
+        if (stats.materialCount[ply] == 0) break;
+        std::cout << "  ply " << ply + 1 << ": " << stats.materialSum[ply] / stats.materialCount[ply]
+                  << " over " << stats.materialCount[ply] << " games\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <games.pgn> [threads]" << std::endl;
+        return 1;
+    }
+
+    int fd = open(argv[1], O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+    size_t size = info.st_size;
+    if (size == 0) {
+        std::cerr << "Empty file " << argv[1] << std::endl;
+        return 1;
+    }
+
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Cannot map " << argv[1] << std::endl;
+        return 1;
+    }
+    madvise(mapped, size, MADV_SEQUENTIAL);
+    const char* data = static_cast<const char*>(mapped);
+
+    unsigned threadCount = argc > 2 ? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+    threadCount = std::max(1u, threadCount);
+    size_t chunkCount = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    long pageSize = sysconf(_SC_PAGESIZE);
+
+    std::atomic<size_t> nextChunk{0};
+    std::vector<GameStats> stats(threadCount);
+    std::vector<std::thread> workers;
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&, t] {
+            ChessBoard board;
+            for (size_t chunk; (chunk = nextChunk.fetch_add(1)) < chunkCount;) {
+                size_t begin = chunk * CHUNK_SIZE;
+                size_t end = std::min(size, begin + CHUNK_SIZE);
+                processChunk(data, size, begin, end, board, stats[t]);
+
+                // Let the kernel drop pages we are done with instead of keeping the whole file resident
+                size_t alignedBegin = begin / pageSize * pageSize;
+                size_t alignedEnd = end / pageSize * pageSize;
+                if (alignedEnd > alignedBegin) {
+                    madvise((char*)mapped + alignedBegin, alignedEnd - alignedBegin, MADV_DONTNEED);
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    GameStats total;
+    for (const GameStats& part : stats) {
+        total.merge(part);
+    }
+    munmap(mapped, size);
+
+    printReport(total, seconds, size);
+    return 0;
+}
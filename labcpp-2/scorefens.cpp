@@ -0,0 +1,187 @@
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <random>
+
+#include "batcheval.cpp"
+
+// Scores positions with every batch kernel the CPU supports, checks them against
+// evaluatePosition() and reports positions per second.
+//   g++ -O2 -std=c++17 scorefens.cpp -o scorefens
+//
+// Usage: scorefens [--kernel scalar|avx2|avx512] [--print] <file with one FEN per line | ->
+//        scorefens [--kernel ...] [--print] --random <positions> [--seed N]
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// How many positions evaluatePosition() is timed on
+const size_t SAMPLE_SIZE = 256;
+
+// Positions along random games from the start position, so that every stage of the game shows up
+void randomPositions(int count, unsigned seed, PositionBatch& batch, std::vector<int32_t>& expected,
+                     std::vector<std::string>& sampleFENs) {
+    std::mt19937 random(seed);
+    ChessBoard board;
+    MoveList moves;
+    int games = 0;
+    while ((int)batch.size() < count) {
+        board.setFEN(START_FEN);
+        ++games;
+        for (int ply = 0; ply < 200 && (int)batch.size() < count; ++ply) {
+            moves.size = 0;
+            board.generateMoves(moves);
+            if (!moves.size) break;
+            board.makeMove(moves[random() % moves.size]);
+            batch.add(board);
+            expected.push_back(evaluatePosition(board));
+            if (sampleFENs.size() < SAMPLE_SIZE) sampleFENs.push_back(board.toFEN());
+        }
+    }
+    std::cout << "Generated " << batch.size() << " positions from " << games << " random games" << std::endl;
+}
+
+bool readPositions(std::istream& in, PositionBatch& batch, std::vector<int32_t>& expected,
+                   std::vector<std::string>& sampleFENs) {
+    ChessBoard board;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (line.empty()) continue;
+        if (!batch.addFEN(line) || !board.setFEN(line)) {
+            std::cerr << "Line " << lineNumber << ": invalid FEN: " << line << std::endl;
+            return false;
+        }
+        expected.push_back(evaluatePosition(board));
+        if (sampleFENs.size() < SAMPLE_SIZE) sampleFENs.push_back(line);
+    }
+    return true;
+}
+
+// Runs the kernel repeatedly for about a fifth of a second and returns positions per second
+double timeKernel(const PositionBatch& batch, BatchKernel kernel, std::vector<int32_t>& scores) {
+    scores.assign(batch.size(), 0);
+    auto start = std::chrono::steady_clock::now();
+    long rounds = 0;
+    do {
+        evaluateBatch(batch, scores.data(), kernel);
+        ++rounds;
+    } while (secondsSince(start) < 0.2);
+    return rounds * batch.size() / secondsSince(start);
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<BatchKernel> kernels = {KERNEL_SCALAR, KERNEL_AVX2, KERNEL_AVX512};
+    bool print = false;
+    bool kernelGiven = false;
+    int randomCount = 0;
+    unsigned seed = 1;
+    std::string path;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (argument == "--kernel" && hasValue) {
+            std::string name = argv[++i];
+            kernels.clear();
+            for (BatchKernel kernel : {KERNEL_SCALAR, KERNEL_AVX2, KERNEL_AVX512}) {
+                if (name == kernelName(kernel)) kernels.push_back(kernel);
+            }
+            if (kernels.empty()) {
+                std::cerr << "Unknown kernel " << name << std::endl;
+                return 1;
+            }
+            kernelGiven = true;
+        } else if (argument == "--print") {
+            print = true;
+        } else if (argument == "--random" && hasValue && std::atoi(argv[i + 1]) > 0) {
+            randomCount = std::atoi(argv[++i]);
+        } else if (argument == "--seed" && hasValue) {
+            seed = std::strtoul(argv[++i], nullptr, 10);
+        } else if (path.empty() && (argument[0] != '-' || argument == "-")) {
+            path = argument;
+        } else {
+            path.clear();
+            randomCount = 0;
+            break;
+        }
+    }
+    if (path.empty() == !randomCount) {
+        std::cerr << "Usage: " << argv[0] << " [--kernel scalar|avx2|avx512] [--print] <fen file | ->\n"
+                  << "       " << argv[0] << " [--kernel scalar|avx2|avx512] [--print] --random <positions> [--seed N]"
+                  << std::endl;
+        return 1;
+    }
+
+    PositionBatch batch;
+    std::vector<int32_t> expected;
+    std::vector<std::string> sampleFENs;
+    if (randomCount) {
+        batch.reserve(randomCount);
+        randomPositions(randomCount, seed, batch, expected, sampleFENs);
+    } else if (path == "-") {
+        if (!readPositions(std::cin, batch, expected, sampleFENs)) return 1;
+    } else {
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "Cannot open " << path << std::endl;
+            return 1;
+        }
+        if (!readPositions(file, batch, expected, sampleFENs)) return 1;
+    }
+    if (!batch.size()) {
+        std::cerr << "No positions" << std::endl;
+        return 1;
+    }
+
+    if (print) {
+        BatchKernel kernel = kernelGiven ? kernels.front() : bestKernel();
+        if (!kernelSupported(kernel)) {
+            std::cerr << kernelName(kernel) << " is not supported by this CPU" << std::endl;
+            return 1;
+        }
+        std::vector<int32_t> scores(batch.size());
+        evaluateBatch(batch, scores.data(), kernel);
+        for (int32_t score : scores) std::cout << score << "\n";
+        return 0;
+    }
+
+    // The reference evaluator on a sample of the positions, set up beforehand
+    std::vector<std::unique_ptr<ChessBoard>> sample;
+    for (const std::string& fen : sampleFENs) {
+        sample.push_back(std::make_unique<ChessBoard>());
+        sample.back()->setFEN(fen);
+    }
+    auto start = std::chrono::steady_clock::now();
+    long rounds = 0;
+    do {
+        for (const std::unique_ptr<ChessBoard>& board : sample) {
+            volatile int score = evaluatePosition(*board);
+            (void)score;
+        }
+        ++rounds;
+    } while (secondsSince(start) < 0.2);
+    std::cout << "evaluatePosition: " << (long)(rounds * sample.size() / secondsSince(start)) << " positions/s" << std::endl;
+
+    bool ok = true;
+    std::vector<int32_t> scores;
+    for (BatchKernel kernel : kernels) {
+        if (!kernelSupported(kernel)) {
+            std::cout << kernelName(kernel) << ": not supported by this CPU" << std::endl;
+            continue;
+        }
+        double rate = timeKernel(batch, kernel, scores);
+        size_t mismatches = 0;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (scores[i] == expected[i]) continue;
+            if (++mismatches <= 5) {
+                std::cout << "  position " << i << ": " << scores[i] << ", expected " << expected[i] << std::endl;
+            }
+        }
+        std::cout << kernelName(kernel) << ": " << (long)rate << " positions/s, "
+                  << (mismatches ? std::to_string(mismatches) + " mismatches" : "all scores match") << std::endl;
+        ok = ok && !mismatches;
+    }
+    return ok ? 0 : 1;
+}
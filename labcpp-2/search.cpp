@@ -0,0 +1,266 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <functional>
+
+#include "chessboard.cpp"
+#include "tablebase.cpp"
+
+const int MAX_DEPTH = 64;
+const int INFINITE_SCORE = 32000;
+const int MATE_SCORE = 31000;
+// Scores at least this far from zero are mates: found by the search within MAX_DEPTH plies, or
+// reported by a tablebase up to MAX_TB_PLIES beyond that
+const int MATE_BOUND = MATE_SCORE - MAX_DEPTH - MAX_TB_PLIES;
+const int64_t NO_DEADLINE = INT64_MAX;
+
+typedef std::chrono::steady_clock SearchClock;
+
+inline int64_t nowMicroseconds() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(SearchClock::now().time_since_epoch()).count();
+}
+
+inline int pieceValueCentipawns(const Piece* piece) {
+    return (int)(piece->value() * 100);
+}
+
+// Material balance from the side to move's point of view, in centipawns
+inline int evaluate(const ChessBoard& board) {
+    int score = 0;
+    for (int square = 0; square < BOARD_SIZE * BOARD_SIZE; ++square) {
+        Piece* piece = board.getPiece(square);
+        if (piece) {
+            score += piece->getColor() == WHITE ? pieceValueCentipawns(piece) : -pieceValueCentipawns(piece);
+        }
+    }
+    return board.getSideToMove() == WHITE ? score : -score;
+}
+
+// Shared between the thread that runs the search and the thread that controls it.
+// Deadlines are absolute nowMicroseconds() values so ponderhit can set them mid-search.
+struct SearchControl {
+    std::atomic<bool> stop{false};
+    std::atomic<int64_t> softDeadline{NO_DEADLINE}; // do not start another iteration after this
+    std::atomic<int64_t> hardDeadline{NO_DEADLINE}; // abort the iteration in progress after this
+
+    void reset() {
+        stop = false;
+        softDeadline = NO_DEADLINE;
+        hardDeadline = NO_DEADLINE;
+    }
+};
+
+struct SearchInfo {
+    int depth;
+    int score;
+    uint64_t nodes;
+    int64_t elapsedMicroseconds;
+    const Move* pv;
+    int pvLength;
+};
+
+class Searcher {
+private:
+    ChessBoard& board;
+    SearchControl& control;
+    std::function<void(const SearchInfo&)> onInfo;
+    const TablebaseSet* tablebases;
+
+    uint64_t nodes;
+    uint64_t nodeLimit;
+    bool aborted;
+    int64_t startTime;
+
+    Move pvTable[MAX_DEPTH + 1][MAX_DEPTH + 1];
+    int pvLength[MAX_DEPTH + 1];
+    Move previousPv[MAX_DEPTH + 1];
+    int previousPvLength;
+
+    // The stop flag is read at every node; the clock only every 1024 nodes
+    bool shouldAbort() {
+        if (aborted) return true;
+        if (control.stop.load(std::memory_order_relaxed) || (nodeLimit && nodes >= nodeLimit)) {
+            aborted = true;
+        } else if ((nodes & 1023) == 0 && nowMicroseconds() >= control.hardDeadline.load(std::memory_order_relaxed)) {
+            aborted = true;
+        }
+        return aborted;
+    }
+
+    int moveOrderScore(const Move& move, int ply) const {
+        if (ply < previousPvLength && move == previousPv[ply]) {
+            return INT_MAX;
+        }
+        int score = 0;
+        if (move.flags & CAPTURE) {
+            Piece* victim = board.getPiece(move.to);
+            int victimValue = victim ? pieceValueCentipawns(victim) : 100;
+            score += 10 * victimValue - pieceValueCentipawns(board.getPiece(move.from)) + 100000;
+        }
+        if (move.promotion != NO_PIECE_TYPE) {
+            score += 90000 + move.promotion;
+        }
+        return score;
+    }
+
+    void orderMoves(MoveList& list, int ply) const {
+        int scores[MAX_MOVES];
+        for (int i = 0; i < list.size; ++i) {
+            scores[i] = moveOrderScore(list[i], ply);
+        }
+        for (int i = 1; i < list.size; ++i) {
+            Move move = list.moves[i];
+            int score = scores[i];
+            int j = i - 1;
+            for (; j >= 0 && scores[j] < score; --j) {
+                list.moves[j + 1] = list.moves[j];
+                scores[j + 1] = scores[j];
+            }
+            list.moves[j + 1] = move;
+            scores[j + 1] = score;
+        }
+    }
+
+    int quiescence(int alpha, int beta, int ply) {
+        ++nodes;
+        if (shouldAbort()) return 0;
+
+        int standPat = evaluate(board);
+        if (standPat >= beta || ply >= MAX_DEPTH) return standPat;
+        if (standPat > alpha) alpha = standPat;
+
+        MoveList list;
+        board.generateMoves(list);
+        int captures = 0;
+        for (int i = 0; i < list.size; ++i) {
+            if ((list[i].flags & CAPTURE) || list[i].promotion == QUEEN) {
+                list.moves[captures++] = list.moves[i];
+            }
+        }
+        list.size = captures;
+        orderMoves(list, MAX_DEPTH);
+
+        for (int i = 0; i < list.size; ++i) {
+            board.makeMove(list[i]);
+            int score = -quiescence(-beta, -alpha, ply + 1);
+            board.unmakeMove();
+            if (aborted) return 0;
+            if (score >= beta) return score;
+            if (score > alpha) alpha = score;
+        }
+        return alpha;
+    }
+
+    int negamax(int depth, int alpha, int beta, int ply) {
+        pvLength[ply] = 0;
+        if (ply > 0 && (board.isRepetition() || board.getHalfmoveClock() >= 100)) {
+            return 0;
+        }
+
+        // Exact result from the endgame tables, without searching further
+        TablebaseResult result;
+        if (ply > 0 && tablebases && board.getPieceCount() <= tablebases->getMaxPieces() && tablebases->probe(board, result)) {
+            if (result.wdl == TB_WIN) return MATE_SCORE - ply - result.plies;
+            if (result.wdl == TB_LOSS) return -MATE_SCORE + ply + result.plies;
+            return 0;
+        }
+
+        if (depth <= 0 || ply >= MAX_DEPTH) {
+            return quiescence(alpha, beta, ply);
+        }
+
+        ++nodes;
+        if (shouldAbort()) return 0;
+
+        MoveList list;
+        board.generateMoves(list);
+        if (list.size == 0) {
+            return board.inCheck() ? -MATE_SCORE + ply : 0;
+        }
+        orderMoves(list, ply);
+
+        int best = -INFINITE_SCORE;
+        for (int i = 0; i < list.size; ++i) {
+            board.makeMove(list[i]);
+            int score = -negamax(depth - 1, -beta, -alpha, ply + 1);
+            board.unmakeMove();
+            if (aborted) return 0;
+
+            if (score > best) {
+                best = score;
+                if (score > alpha) {
+                    alpha = score;
+                    pvTable[ply][0] = list[i];
+                    for (int j = 0; j < pvLength[ply + 1]; ++j) {
+                        pvTable[ply][j + 1] = pvTable[ply + 1][j];
+                    }
+                    pvLength[ply] = pvLength[ply + 1] + 1;
+                }
+                if (score >= beta) break;
+            }
+        }
+        return best;
+    }
+
+public:
+    Searcher(ChessBoard& board, SearchControl& control, std::function<void(const SearchInfo&)> onInfo)
+        : board(board), control(control), onInfo(onInfo), tablebases(nullptr), nodes(0), nodeLimit(0), aborted(false),
+          startTime(0), previousPvLength(0) {}
+
+    void setTablebases(const TablebaseSet* set) {
+        tablebases = set;
+    }
+
+    uint64_t getNodes() const {
+        return nodes;
+    }
+
+    // Iterative deepening. Returns the best move of the last completed iteration and fills ponder
+    // with the expected reply when there is one. Returns false if the position has no legal moves.
+    bool run(int maxDepth, uint64_t maxNodes, Move& best, Move& ponder, bool& hasPonder) {
+        nodes = 0;
+        nodeLimit = maxNodes;
+        aborted = false;
+        previousPvLength = 0;
+        startTime = nowMicroseconds();
+        hasPonder = false;
+
+        MoveList rootMoves;
+        board.generateMoves(rootMoves);
+        if (rootMoves.size == 0) {
+            return false;
+        }
+        best = rootMoves[0];
+
+        for (int depth = 1; depth <= std::min(maxDepth, MAX_DEPTH); ++depth) {
+            int score = negamax(depth, -INFINITE_SCORE, INFINITE_SCORE, 0);
+            if (aborted && depth > 1) {
+                break;
+            }
+
+            if (pvLength[0] > 0) {
+                previousPvLength = pvLength[0];
+                for (int i = 0; i < pvLength[0]; ++i) {
+                    previousPv[i] = pvTable[0][i];
+                }
+                best = previousPv[0];
+                hasPonder = previousPvLength > 1;
+                if (hasPonder) ponder = previousPv[1];
+            }
+
+            if (onInfo) {
+                onInfo(SearchInfo{depth, score, nodes, nowMicroseconds() - startTime, previousPv, previousPvLength});
+            }
+
+            if (aborted || score >= MATE_SCORE - depth || score <= -MATE_SCORE + depth) {
+                break;
+            }
+            if (nowMicroseconds() >= control.softDeadline.load(std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        return true;
+    }
+};
@@ -0,0 +1,567 @@
+#pragma once
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "chessboard.cpp"
+
+// Endgame tablebases for up to four pieces, kings included.
+//
+// A table covers one material set such as "KQKR" (white pieces after the first K, black after the second)
+// and stores, for every position and side to move, win/draw/loss and the number of plies to mate.
+// Entries are bit-packed, just wide enough for the longest mate of the table, so a file can be
+// memory-mapped and probed in place.
+//
+// Positions are indexed by the square of every piece, in the order of the material string. One piece,
+// the anchor, is reduced by symmetry: without pawns the white king is mapped into the a1-d1-d4 triangle
+// (8 symmetries), with pawns the first pawn is mapped to files a-d (left-right mirror).
+// En passant and castling are not part of the index.
+
+const int MAX_TB_PIECES = 4;
+const int TB_PAWNLESS_ANCHORS = 10;
+const int TB_PAWN_ANCHORS = 24;
+const char TB_MAGIC[8] = "SSUTB01";
+// Plies to mate are generated into a byte; an en passant capture in front of them adds one more
+const int MAX_TB_PLIES = 256;
+// Material signatures: a base-3 digit per color and piece type other than the king, which is
+// enough for the at most two such pieces a table has
+const int TB_SIGNATURES = 59049; // 3^10
+
+enum TablebaseWDL {
+    TB_DRAW,
+    TB_WIN,
+    TB_LOSS,
+    TB_ILLEGAL
+};
+
+// From the point of view of the side to move
+struct TablebaseResult {
+    TablebaseWDL wdl;
+    int plies;
+};
+
+struct TbPiece {
+    PieceType type;
+    Color color;
+    int square;
+};
+
+struct TablebaseHeader {
+    char magic[8];
+    char material[8];
+    uint32_t bitsPerEntry;
+    uint32_t maxPlies;
+    uint64_t entryCount;
+};
+
+inline char pieceLetter(PieceType type) {
+    return "PNBRQK"[type];
+}
+
+inline PieceType letterPiece(char letter) {
+    switch (letter) {
+        case 'P': return PAWN;
+        case 'N': return KNIGHT;
+        case 'B': return BISHOP;
+        case 'R': return ROOK;
+        case 'Q': return QUEEN;
+        case 'K': return KING;
+        default:  return NO_PIECE_TYPE;
+    }
+}
+
+// Strongest piece first, so equal material always gets the same name
+inline std::string sortPieces(std::string pieces) {
+    std::sort(pieces.begin(), pieces.end(), [](char a, char b) {
+        return letterPiece(a) > letterPiece(b);
+    });
+    return pieces;
+}
+
+inline double sideValue(const std::string& pieces) {
+    double value = 0;
+    for (char letter : pieces) {
+        value += pieceTypeValue(letterPiece(letter));
+    }
+    return value;
+}
+
+// Name under which a table is generated: the stronger side plays white
+inline std::string normalizeMaterial(const std::string& white, const std::string& black) {
+    std::string strong = sortPieces(white), weak = sortPieces(black);
+    if (sideValue(weak) > sideValue(strong) || (sideValue(weak) == sideValue(strong) && weak > strong)) {
+        std::swap(strong, weak);
+    }
+    return "K" + strong + "K" + weak;
+}
+
+// Only a lone minor piece (or nothing) besides the kings: nobody can be mated
+inline bool isInsufficientMaterial(const std::string& white, const std::string& black) {
+    std::string all = white + black;
+    return all.empty() || (all.size() == 1 && (all[0] == 'B' || all[0] == 'N'));
+}
+
+struct TbMaterial {
+    int count = 0;
+    PieceType types[MAX_TB_PIECES];
+    Color colors[MAX_TB_PIECES];
+    int anchor = 0;
+    bool hasPawns = false;
+    std::string white, black;
+
+    bool parse(const std::string& name) {
+        size_t second = name.find('K', 1);
+        if (name.empty() || name[0] != 'K' || second == std::string::npos || name.size() > MAX_TB_PIECES) {
+            return false;
+        }
+        white = name.substr(1, second - 1);
+        black = name.substr(second + 1);
+
+        count = 0;
+        hasPawns = false;
+        std::string slots = "K" + white + "K" + black;
+        for (size_t i = 0; i < slots.size(); ++i) {
+            types[count] = letterPiece(slots[i]);
+            colors[count] = i <= white.size() ? WHITE : BLACK;
+            if (types[count] == NO_PIECE_TYPE || (types[count] == KING && i != 0 && i != white.size() + 1)) {
+                return false;
+            }
+            if (types[count] == PAWN && !hasPawns) {
+                hasPawns = true;
+                anchor = count;
+            }
+            ++count;
+        }
+        if (!hasPawns) {
+            anchor = 0;
+        }
+        return true;
+    }
+
+    std::string name() const {
+        return "K" + white + "K" + black;
+    }
+
+    uint64_t sideSize() const {
+        uint64_t size = hasPawns ? TB_PAWN_ANCHORS : TB_PAWNLESS_ANCHORS;
+        for (int i = 1; i < count; ++i) {
+            size *= BOARD_SIZE * BOARD_SIZE;
+        }
+        return size;
+    }
+
+    uint64_t entryCount() const {
+        return 2 * sideSize();
+    }
+};
+
+// The eight board symmetries: bit 0 mirrors files, bit 1 mirrors ranks, bit 2 swaps files and ranks
+inline int tbTransform(int square, int transform) {
+    int file = fileOf(square), rank = BOARD_SIZE - 1 - rowOf(square);
+    if (transform & 1) file = BOARD_SIZE - 1 - file;
+    if (transform & 2) rank = BOARD_SIZE - 1 - rank;
+    if (transform & 4) std::swap(file, rank);
+    return squareIndex(file, BOARD_SIZE - 1 - rank);
+}
+
+// Anchor slot in [0, 10) for the a1-d1-d4 triangle or [0, 24) for a pawn on files a-d; -1 outside
+inline int tbAnchorIndex(int square, bool pawn) {
+    int file = fileOf(square), rank = BOARD_SIZE - 1 - rowOf(square);
+    if (pawn) {
+        return file <= 3 && rank >= 1 && rank <= 6 ? (rank - 1) * 4 + file : -1;
+    }
+    if (file > 3 || rank > file) {
+        return -1;
+    }
+    return file * (file + 1) / 2 + rank;
+}
+
+inline int tbAnchorSquare(int index, bool pawn) {
+    if (pawn) {
+        return squareIndex(index % 4, BOARD_SIZE - 1 - (index / 4 + 1));
+    }
+    int file = 0;
+    while ((file + 1) * (file + 2) / 2 <= index) ++file;
+    return squareIndex(file, BOARD_SIZE - 1 - (index - file * (file + 1) / 2));
+}
+
+// Index of a position whose squares are in material slot order. Returns false if no symmetry
+// brings the anchor into its region (only possible for a pawn on the first or last rank).
+inline bool tbIndex(const TbMaterial& material, const int* squares, Color sideToMove, uint64_t& index, int* transformUsed = nullptr) {
+    int transforms = material.hasPawns ? 2 : 8;
+    for (int t = 0; t < transforms; ++t) {
+        int anchor = tbAnchorIndex(tbTransform(squares[material.anchor], t), material.hasPawns);
+        if (anchor < 0) continue;
+
+        index = anchor;
+        for (int i = 0; i < material.count; ++i) {
+            if (i != material.anchor) {
+                index = index * (BOARD_SIZE * BOARD_SIZE) + tbTransform(squares[i], t);
+            }
+        }
+        index += sideToMove == WHITE ? 0 : material.sideSize();
+        if (transformUsed) *transformUsed = t;
+        return true;
+    }
+    return false;
+}
+
+inline void tbDecode(const TbMaterial& material, uint64_t index, int* squares, Color& sideToMove) {
+    sideToMove = index >= material.sideSize() ? BLACK : WHITE;
+    index %= material.sideSize();
+    for (int i = material.count - 1; i >= 0; --i) {
+        if (i == material.anchor) continue;
+        squares[i] = index % (BOARD_SIZE * BOARD_SIZE);
+        index /= BOARD_SIZE * BOARD_SIZE;
+    }
+    squares[material.anchor] = tbAnchorSquare(index, material.hasPawns);
+}
+
+// A single memory-mapped table
+class Tablebase {
+private:
+    TbMaterial material;
+    void* mapping;
+    size_t mappedSize;
+    const uint64_t* words;
+    uint64_t entries;
+    int bits;
+    int maxPlies;
+
+public:
+    Tablebase() : mapping(nullptr), mappedSize(0), words(nullptr), entries(0), bits(0), maxPlies(0) {}
+
+    Tablebase(const Tablebase&) = delete;
+    Tablebase& operator=(const Tablebase&) = delete;
+
+    ~Tablebase() {
+        close();
+    }
+
+    bool open(const std::string& path) {
+        close();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(TablebaseHeader)) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+
+        const TablebaseHeader* header = static_cast<const TablebaseHeader*>(mapped);
+        std::string name(header->material, strnlen(header->material, sizeof(header->material)));
+        uint64_t payload = (header->entryCount * header->bitsPerEntry + 63) / 64 + 1;
+        if (memcmp(header->magic, TB_MAGIC, sizeof(TB_MAGIC)) != 0 || !material.parse(name)
+            || header->entryCount != material.entryCount()
+            || (uint64_t)info.st_size < sizeof(TablebaseHeader) + payload * sizeof(uint64_t)) {
+            munmap(mapped, info.st_size);
+            return false;
+        }
+
+        mapping = mapped;
+        mappedSize = info.st_size;
+        words = reinterpret_cast<const uint64_t*>(static_cast<const char*>(mapped) + sizeof(TablebaseHeader));
+        entries = header->entryCount;
+        bits = header->bitsPerEntry;
+        maxPlies = header->maxPlies;
+        return true;
+    }
+
+    void close() {
+        if (mapping) {
+            munmap(mapping, mappedSize);
+        }
+        mapping = nullptr;
+        words = nullptr;
+        entries = 0;
+    }
+
+    const TbMaterial& getMaterial() const {
+        return material;
+    }
+
+    int getMaxPlies() const {
+        return maxPlies;
+    }
+
+    uint64_t size() const {
+        return entries;
+    }
+
+    TablebaseResult read(uint64_t index) const {
+        uint64_t bit = index * bits;
+        uint64_t word = bit >> 6;
+        int shift = bit & 63;
+        uint64_t value = words[word] >> shift;
+        if (shift + bits > 64) {
+            value |= words[word + 1] << (64 - shift);
+        }
+        value &= (1ull << bits) - 1;
+        return TablebaseResult{(TablebaseWDL)(value & 3), (int)(value >> 2)};
+    }
+
+    TablebaseResult probe(const int* squares, Color sideToMove) const {
+        uint64_t index;
+        if (!tbIndex(material, squares, sideToMove, index)) {
+            return TablebaseResult{TB_ILLEGAL, 0};
+        }
+        return read(index);
+    }
+
+    // Packs per-entry results into a table file; wdl and plies hold one value per index
+    static bool write(const std::string& path, const TbMaterial& material,
+                      const std::vector<uint8_t>& wdl, const std::vector<uint8_t>& plies) {
+        uint64_t count = material.entryCount();
+        int maxPlies = 0;
+        for (uint64_t i = 0; i < count; ++i) {
+            maxPlies = std::max<int>(maxPlies, plies[i]);
+        }
+        int bits = 2;
+        while ((1 << (bits - 2)) <= maxPlies) ++bits;
+
+        std::vector<uint64_t> packed((count * bits + 63) / 64 + 1, 0);
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t value = wdl[i] | (uint64_t)plies[i] << 2;
+            uint64_t bit = i * bits;
+            packed[bit >> 6] |= value << (bit & 63);
+            if ((bit & 63) + bits > 64) {
+                packed[(bit >> 6) + 1] |= value >> (64 - (bit & 63));
+            }
+        }
+
+        TablebaseHeader header = {};
+        memcpy(header.magic, TB_MAGIC, sizeof(TB_MAGIC));
+        std::string name = material.name();
+        memcpy(header.material, name.data(), std::min(name.size(), sizeof(header.material)));
+        header.bitsPerEntry = bits;
+        header.maxPlies = maxPlies;
+        header.entryCount = count;
+
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(packed.data()), packed.size() * sizeof(uint64_t));
+        return (bool)out;
+    }
+};
+
+inline int tbSignatureDigit(PieceType type, Color color) {
+    const int powers[10] = {1, 3, 9, 27, 81, 243, 729, 2187, 6561, 19683};
+    return powers[color * KING + type];
+}
+
+// All loaded tables; finds the right one for any position, with colors swapped if needed
+class TablebaseSet {
+private:
+    // A table and whether the position's colors have to be swapped to probe it
+    struct TableRef {
+        const Tablebase* table;
+        bool flipped;
+    };
+
+    std::vector<std::unique_ptr<Tablebase>> tables;
+    // Resolved once when a table is added, so a probe does no string work and no table search
+    std::vector<TableRef> bySignature;
+    int maxPieces;
+
+    // Signature of the material with colors as in the table, or swapped
+    static int signature(const TbMaterial& material, bool swapColors) {
+        int result = 0;
+        for (int slot = 0; slot < material.count; ++slot) {
+            if (material.types[slot] == KING) continue;
+            Color color = swapColors ? (material.colors[slot] == WHITE ? BLACK : WHITE) : material.colors[slot];
+            result += tbSignatureDigit(material.types[slot], color);
+        }
+        return result;
+    }
+
+    const Tablebase* find(const std::string& name) const {
+        for (const std::unique_ptr<Tablebase>& table : tables) {
+            if (table->getMaterial().name() == name) {
+                return table.get();
+            }
+        }
+        return nullptr;
+    }
+
+public:
+    TablebaseSet() : bySignature(TB_SIGNATURES, TableRef{nullptr, false}), maxPieces(0) {}
+
+    bool add(const std::string& path) {
+        std::unique_ptr<Tablebase> table(new Tablebase());
+        if (!table->open(path)) {
+            return false;
+        }
+        // The first table of a material wins, and a table in its own colors beats a swapped one
+        const TbMaterial& material = table->getMaterial();
+        TableRef& direct = bySignature[signature(material, false)];
+        if (!direct.table || direct.flipped) {
+            direct = TableRef{table.get(), false};
+        }
+        TableRef& swapped = bySignature[signature(material, true)];
+        if (!swapped.table) {
+            swapped = TableRef{table.get(), true};
+        }
+        maxPieces = std::max(maxPieces, material.count);
+        tables.push_back(std::move(table));
+        return true;
+    }
+
+    // Loads every *.tb file of a directory, returns how many were loaded
+    int loadDirectory(const std::string& directory) {
+        DIR* dir = opendir(directory.c_str());
+        if (!dir) {
+            return 0;
+        }
+        int loaded = 0;
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, ".tb") == 0) {
+                loaded += add(directory + "/" + name);
+            }
+        }
+        closedir(dir);
+        return loaded;
+    }
+
+    bool has(const std::string& name) const {
+        return find(name) != nullptr;
+    }
+
+    int getMaxPieces() const {
+        return maxPieces;
+    }
+
+    bool probe(const TbPiece* pieces, int count, Color sideToMove, TablebaseResult& result) const {
+        if (count > MAX_TB_PIECES) {
+            return false;
+        }
+
+        int kings = 0, others = 0, key = 0;
+        PieceType other = NO_PIECE_TYPE;
+        for (int i = 0; i < count; ++i) {
+            if (pieces[i].type == KING) {
+                ++kings;
+            } else {
+                ++others;
+                other = pieces[i].type;
+                key += tbSignatureDigit(pieces[i].type, pieces[i].color);
+            }
+        }
+        if (kings != 2) {
+            return false;
+        }
+        // Only a lone minor piece (or nothing) besides the kings: nobody can be mated
+        if (others == 0 || (others == 1 && (other == BISHOP || other == KNIGHT))) {
+            result = TablebaseResult{TB_DRAW, 0};
+            return true;
+        }
+
+        const TableRef& ref = bySignature[key];
+        if (!ref.table) {
+            return false;
+        }
+        const Tablebase* table = ref.table;
+        bool flipped = ref.flipped;
+
+        // With colors swapped, black plays white's role and the board is mirrored top to bottom
+        const TbMaterial& material = table->getMaterial();
+        int squares[MAX_TB_PIECES];
+        bool used[MAX_TB_PIECES] = {};
+        for (int slot = 0; slot < material.count; ++slot) {
+            Color color = flipped ? (material.colors[slot] == WHITE ? BLACK : WHITE) : material.colors[slot];
+            for (int i = 0; i < count; ++i) {
+                if (!used[i] && pieces[i].type == material.types[slot] && pieces[i].color == color) {
+                    used[i] = true;
+                    squares[slot] = flipped ? pieces[i].square ^ 56 : pieces[i].square;
+                    break;
+                }
+            }
+        }
+        Color side = flipped ? (sideToMove == WHITE ? BLACK : WHITE) : sideToMove;
+        result = table->probe(squares, side);
+        return result.wdl != TB_ILLEGAL;
+    }
+
+    // O(1): one scan of the board, one index computation, one read from the mapped file.
+    // The tables ignore en passant, so when it is possible each capture is probed as well and the
+    // best of the results is taken. (A position where the capture is the only legal move and
+    // everything else would be stalemate is still reported as a draw.)
+    bool probe(const ChessBoard& board, TablebaseResult& result) const {
+        if (board.getPieceCount() > maxPieces || board.getCastlingRights() != 0) {
+            return false;
+        }
+        TbPiece pieces[MAX_TB_PIECES];
+        int count = 0;
+        for (int square = 0; square < BOARD_SIZE * BOARD_SIZE; ++square) {
+            Piece* piece = board.getPiece(square);
+            if (piece) {
+                pieces[count++] = TbPiece{piece->type(), piece->getColor(), square};
+            }
+        }
+        Color side = board.getSideToMove();
+        if (!probe(pieces, count, side, result)) {
+            return false;
+        }
+        if (!board.canCaptureEnPassant()) {
+            return true;
+        }
+
+        int target = board.getEnPassantSquare();
+        int victim = target + (side == WHITE ? BOARD_SIZE : -BOARD_SIZE);
+        for (int i = 0; i < count; ++i) {
+            int from = pieces[i].square;
+            if (pieces[i].type != PAWN || pieces[i].color != side || rowOf(from) != rowOf(victim)
+                || std::abs(fileOf(from) - fileOf(victim)) != 1) {
+                continue;
+            }
+            TbPiece after[MAX_TB_PIECES];
+            int afterCount = 0;
+            for (int j = 0; j < count; ++j) {
+                if (pieces[j].square == victim) continue;
+                after[afterCount] = pieces[j];
+                if (j == i) after[afterCount].square = target;
+                ++afterCount;
+            }
+            // An illegal result means the capture leaves the own king in check
+            TablebaseResult reply;
+            if (!probe(after, afterCount, side == WHITE ? BLACK : WHITE, reply)) {
+                continue;
+            }
+            TablebaseResult capture{TB_DRAW, 0};
+            if (reply.wdl == TB_LOSS) capture = TablebaseResult{TB_WIN, reply.plies + 1};
+            if (reply.wdl == TB_WIN) capture = TablebaseResult{TB_LOSS, reply.plies + 1};
+            if (isBetter(capture, result)) {
+                result = capture;
+            }
+        }
+        return true;
+    }
+
+    // Whether a is better than b for the side to move: faster wins, then draws, then slower losses
+    static bool isBetter(const TablebaseResult& a, const TablebaseResult& b) {
+        if (a.wdl != b.wdl) {
+            const int rank[] = {1, 2, 0}; // TB_DRAW, TB_WIN, TB_LOSS
+            return rank[a.wdl] > rank[b.wdl];
+        }
+        if (a.wdl == TB_WIN) return a.plies < b.plies;
+        if (a.wdl == TB_LOSS) return a.plies > b.plies;
+        return false;
+    }
+};
@@ -0,0 +1,642 @@
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <random>
+#include <thread>
+
+#include "tablebase.cpp"
+
+// Retrograde tablebase generator.
+//
+// 1. Every position is classified once, in parallel over index ranges: illegal, mate, stalemate, or the
+//    number of moves that stay inside the table. Captures and promotions leave the table and are looked
+//    up in the smaller tables, which are generated first.
+// 2. Starting from the mates, results are propagated backwards one ply at a time with un-moves.
+//    A predecessor of a lost position is won; a predecessor whose last internal move turned out to
+//    lead to a won position is lost. Whatever is left at the end is a draw.
+//
+// Usage: tbgen [--threads N] [--verify] <directory> <material>...
+//        e.g. tbgen tb KQK KRK KPK KQKR KBNK
+
+enum GenState : uint8_t {
+    GEN_UNKNOWN,
+    GEN_WIN,
+    GEN_LOSS,
+    GEN_DRAW,
+    GEN_ILLEGAL
+};
+
+const uint8_t EXTERNAL_DRAW = 1;
+const uint8_t EXTERNAL_WIN = 2;
+
+// Longest mates in moves, as published for these endgames
+struct KnownResult {
+    const char* material;
+    int maxMateMoves;
+};
+
+const KnownResult KNOWN_RESULTS[] = {
+    {"KQK", 10},
+    {"KRK", 16},
+    {"KPK", 28},
+    {"KBBK", 19},
+    {"KBNK", 33},
+    {"KQKR", 35},
+    {"KRKN", 40},
+};
+
+const int KNIGHT_STEPS[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+const int KING_STEPS[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+
+// A few pieces on an otherwise empty board: all a table needs, without ChessBoard's heap pieces
+struct TbBoard {
+    const TbMaterial& material;
+    int squares[MAX_TB_PIECES];
+    int8_t occupant[BOARD_SIZE * BOARD_SIZE];
+
+    TbBoard(const TbMaterial& material, const int* source) : material(material) {
+        std::fill(occupant, occupant + BOARD_SIZE * BOARD_SIZE, -1);
+        for (int i = 0; i < material.count; ++i) {
+            squares[i] = source[i];
+            if (squares[i] >= 0) occupant[squares[i]] = i;
+        }
+    }
+
+    bool isEmpty(int file, int row) const {
+        return occupant[squareIndex(file, row)] < 0;
+    }
+
+    bool attacks(int slot, int target) const {
+        int from = squares[slot];
+        int dx = fileOf(target) - fileOf(from), dy = rowOf(target) - rowOf(from);
+        switch (material.types[slot]) {
+            case PAWN:
+                return std::abs(dx) == 1 && dy == (material.colors[slot] == WHITE ? -1 : 1);
+            case KNIGHT:
+                return (std::abs(dx) == 1 && std::abs(dy) == 2) || (std::abs(dx) == 2 && std::abs(dy) == 1);
+            case KING:
+                return std::max(std::abs(dx), std::abs(dy)) == 1;
+            default:
+                break;
+        }
+
+        bool straight = dx == 0 || dy == 0;
+        bool diagonal = std::abs(dx) == std::abs(dy);
+        PieceType type = material.types[slot];
+        if ((dx == 0 && dy == 0) || (!straight && !diagonal) || (straight && type == BISHOP) || (diagonal && type == ROOK)) {
+            return false;
+        }
+        int stepX = (dx > 0) - (dx < 0), stepY = (dy > 0) - (dy < 0);
+        for (int x = fileOf(from) + stepX, y = rowOf(from) + stepY; x != fileOf(target) || y != rowOf(target); x += stepX, y += stepY) {
+            if (!isEmpty(x, y)) return false;
+        }
+        return true;
+    }
+
+    bool isAttacked(int square, Color by) const {
+        for (int i = 0; i < material.count; ++i) {
+            if (squares[i] >= 0 && material.colors[i] == by && attacks(i, square)) return true;
+        }
+        return false;
+    }
+
+    int kingOf(Color color) const {
+        return color == WHITE ? 0 : (int)material.white.size() + 1;
+    }
+};
+
+class Generator {
+private:
+    TbMaterial material;
+    const TablebaseSet& smaller;
+    int threadCount;
+
+    std::vector<std::atomic<uint8_t>> state;
+    std::vector<uint8_t> plies;
+    std::vector<std::atomic<uint8_t>> remaining;
+    std::vector<uint8_t> external;
+    std::vector<uint8_t> externalLoss;
+
+    std::vector<std::vector<uint32_t>> winAt, lossAt;
+
+    static void schedule(std::vector<std::vector<uint32_t>>& buckets, int level, uint32_t index) {
+        if ((int)buckets.size() <= level) buckets.resize(level + 1);
+        buckets[level].push_back(index);
+    }
+
+    // Visits every move of the side to move: visit(squares after the move, moved slot, captured slot or -1, promotion)
+    template <typename Visit>
+    void forEachMove(const TbBoard& board, Color side, Visit visit) const {
+        for (int slot = 0; slot < material.count; ++slot) {
+            if (material.colors[slot] != side) continue;
+            int from = board.squares[slot];
+            int x = fileOf(from), y = rowOf(from);
+
+            auto tryTarget = [&](int i, int j, bool canCapture, bool mustCapture) {
+                if (i < 0 || i >= BOARD_SIZE || j < 0 || j >= BOARD_SIZE) return false;
+                int to = squareIndex(i, j);
+                int captured = board.occupant[to];
+                if (captured >= 0 && (!canCapture || material.colors[captured] == side)) return false;
+                if (captured < 0 && mustCapture) return true;
+
+                int after[MAX_TB_PIECES];
+                std::copy(board.squares, board.squares + material.count, after);
+                after[slot] = to;
+                if (captured >= 0) after[captured] = -1;
+
+                bool promotes = material.types[slot] == PAWN && (j == 0 || j == BOARD_SIZE - 1);
+                if (promotes) {
+                    for (int promotion = QUEEN; promotion >= KNIGHT; --promotion) {
+                        visit(after, slot, captured, (PieceType)promotion);
+                    }
+                } else {
+                    visit(after, slot, captured, NO_PIECE_TYPE);
+                }
+                return captured < 0;
+            };
+
+            switch (material.types[slot]) {
+                case PAWN: {
+                    int dy = side == WHITE ? -1 : 1;
+                    if (board.isEmpty(x, y + dy)) {
+                        tryTarget(x, y + dy, false, false);
+                        int startRow = side == WHITE ? BOARD_SIZE - 2 : 1;
+                        if (y == startRow && board.isEmpty(x, y + 2 * dy)) {
+                            tryTarget(x, y + 2 * dy, false, false);
+                        }
+                    }
+                    tryTarget(x - 1, y + dy, true, true);
+                    tryTarget(x + 1, y + dy, true, true);
+                    break;
+                }
+                case KNIGHT:
+                    for (const int* step : KNIGHT_STEPS) tryTarget(x + step[0], y + step[1], true, false);
+                    break;
+                case KING:
+                    for (const int* step : KING_STEPS) tryTarget(x + step[0], y + step[1], true, false);
+                    break;
+                default:
+                    for (const int* step : KING_STEPS) {
+                        bool straight = step[0] == 0 || step[1] == 0;
+                        if ((straight && material.types[slot] == BISHOP) || (!straight && material.types[slot] == ROOK)) continue;
+                        for (int i = x + step[0], j = y + step[1]; tryTarget(i, j, true, false); i += step[0], j += step[1]) {
+                        }
+                    }
+                    break;
+            }
+        }
+    }
+
+    // Visits every position, with the other side to move, from which a non-capturing, non-promoting
+    // move of that side leads to this one
+    template <typename Visit>
+    void forEachUnmove(const TbBoard& board, Color mover, Visit visit) const {
+        for (int slot = 0; slot < material.count; ++slot) {
+            if (material.colors[slot] != mover) continue;
+            int to = board.squares[slot];
+            int x = fileOf(to), y = rowOf(to);
+
+            auto tryOrigin = [&](int i, int j) {
+                if (i < 0 || i >= BOARD_SIZE || j < 0 || j >= BOARD_SIZE || !board.isEmpty(i, j)) return false;
+                int before[MAX_TB_PIECES];
+                std::copy(board.squares, board.squares + material.count, before);
+                before[slot] = squareIndex(i, j);
+                visit(before);
+                return true;
+            };
+
+            switch (material.types[slot]) {
+                case PAWN: {
+                    // Pawns came from one row behind, or two from their start row
+                    int back = mover == WHITE ? 1 : -1;
+                    int startRow = mover == WHITE ? BOARD_SIZE - 2 : 1;
+                    if (y + back < 1 || y + back > BOARD_SIZE - 2) break;
+                    if (tryOrigin(x, y + back) && y + 2 * back == startRow) {
+                        tryOrigin(x, y + 2 * back);
+                    }
+                    break;
+                }
+                case KNIGHT:
+                    for (const int* step : KNIGHT_STEPS) tryOrigin(x + step[0], y + step[1]);
+                    break;
+                case KING:
+                    for (const int* step : KING_STEPS) tryOrigin(x + step[0], y + step[1]);
+                    break;
+                default:
+                    for (const int* step : KING_STEPS) {
+                        bool straight = step[0] == 0 || step[1] == 0;
+                        if ((straight && material.types[slot] == BISHOP) || (!straight && material.types[slot] == ROOK)) continue;
+                        for (int i = x + step[0], j = y + step[1]; tryOrigin(i, j); i += step[0], j += step[1]) {
+                        }
+                    }
+                    break;
+            }
+        }
+    }
+
+    bool isLegalPosition(const TbBoard& board, Color sideToMove) const {
+        for (int i = 0; i < material.count; ++i) {
+            if (board.occupant[board.squares[i]] != i) return false; // two pieces on one square
+            int row = rowOf(board.squares[i]);
+            if (material.types[i] == PAWN && (row == 0 || row == BOARD_SIZE - 1)) return false;
+        }
+        Color other = sideToMove == WHITE ? BLACK : WHITE;
+        return !board.isAttacked(board.squares[board.kingOf(other)], sideToMove);
+    }
+
+    // Result of a capture or promotion, from the point of view of the side that moved
+    TablebaseResult probeExternal(const int* after, PieceType promotion, int movedSlot, Color side) const {
+        TbPiece pieces[MAX_TB_PIECES];
+        int count = 0;
+        for (int i = 0; i < material.count; ++i) {
+            if (after[i] < 0) continue;
+            PieceType type = (i == movedSlot && promotion != NO_PIECE_TYPE) ? promotion : material.types[i];
+            pieces[count++] = TbPiece{type, material.colors[i], after[i]};
+        }
+        TablebaseResult result;
+        if (!smaller.probe(pieces, count, side == WHITE ? BLACK : WHITE, result)) {
+            throw std::runtime_error("missing tablebase for a capture or promotion from " + material.name());
+        }
+        return result;
+    }
+
+    void classify(uint64_t begin, uint64_t end, std::vector<std::vector<uint32_t>>& wins,
+                  std::vector<std::vector<uint32_t>>& losses) {
+        for (uint64_t index = begin; index < end; ++index) {
+            int squares[MAX_TB_PIECES];
+            Color side;
+            tbDecode(material, index, squares, side);
+            TbBoard board(material, squares);
+            if (!isLegalPosition(board, side)) {
+                state[index] = GEN_ILLEGAL;
+                continue;
+            }
+
+            int legalMoves = 0, internalMoves = 0, bestWin = INT_MAX, worstLoss = 0;
+            bool externalDraw = false;
+            int king = board.kingOf(side);
+            Color other = side == WHITE ? BLACK : WHITE;
+
+            forEachMove(board, side, [&](const int* after, int moved, int captured, PieceType promotion) {
+                TbBoard child(material, after);
+                if (child.isAttacked(after[king], other)) return;
+                ++legalMoves;
+                if (captured < 0 && promotion == NO_PIECE_TYPE) {
+                    ++internalMoves;
+                    return;
+                }
+                TablebaseResult result = probeExternal(after, promotion, moved, side);
+                if (result.wdl == TB_LOSS) bestWin = std::min(bestWin, result.plies + 1);
+                else if (result.wdl == TB_WIN) worstLoss = std::max(worstLoss, result.plies + 1);
+                else externalDraw = true;
+            });
+
+            remaining[index] = internalMoves;
+            externalLoss[index] = worstLoss;
+            external[index] = (externalDraw ? EXTERNAL_DRAW : 0) | (bestWin != INT_MAX ? EXTERNAL_WIN : 0);
+
+            if (legalMoves == 0) {
+                if (board.isAttacked(squares[king], other)) {
+                    schedule(losses, 0, index);
+                } else {
+                    state[index] = GEN_DRAW;
+                }
+            } else if (bestWin != INT_MAX) {
+                schedule(wins, bestWin, index);
+            } else if (internalMoves == 0) {
+                if (externalDraw) {
+                    state[index] = GEN_DRAW;
+                } else {
+                    schedule(losses, worstLoss, index);
+                }
+            }
+        }
+    }
+
+    // Un-moves from every placement of the pieces that shares this index, keeping predecessors that are
+    // stored as themselves: each (predecessor, move) pair is then seen exactly once.
+    template <typename Visit>
+    void forEachPredecessor(uint64_t index, Visit visit) const {
+        int squares[MAX_TB_PIECES];
+        Color side;
+        tbDecode(material, index, squares, side);
+        Color mover = side == WHITE ? BLACK : WHITE;
+
+        int images[8][MAX_TB_PIECES];
+        int imageCount = 0;
+        int transforms = material.hasPawns ? 2 : 8;
+        for (int t = 0; t < transforms; ++t) {
+            int image[MAX_TB_PIECES];
+            for (int i = 0; i < material.count; ++i) {
+                image[i] = tbTransform(squares[i], t);
+            }
+            uint64_t imageIndex;
+            if (!tbIndex(material, image, side, imageIndex) || imageIndex != index) continue;
+            bool seen = false;
+            for (int k = 0; k < imageCount && !seen; ++k) {
+                seen = std::equal(image, image + material.count, images[k]);
+            }
+            if (seen) continue;
+            std::copy(image, image + material.count, images[imageCount++]);
+
+            TbBoard board(material, image);
+            forEachUnmove(board, mover, [&](const int* before) {
+                uint64_t previous;
+                int transform;
+                if (tbIndex(material, before, mover, previous, &transform) && transform == 0) {
+                    visit(previous);
+                }
+            });
+        }
+    }
+
+    template <typename Work>
+    void parallel(uint64_t count, Work work) {
+        std::vector<std::thread> threads;
+        uint64_t step = (count + threadCount - 1) / threadCount;
+        for (int t = 0; t < threadCount; ++t) {
+            uint64_t begin = std::min(count, t * step), end = std::min(count, begin + step);
+            threads.emplace_back([&, t, begin, end] { work(t, begin, end); });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    template <typename T>
+    void mergeBuckets(std::vector<std::vector<std::vector<T>>>& local, std::vector<std::vector<T>>& buckets) {
+        for (std::vector<std::vector<T>>& part : local) {
+            for (size_t level = 0; level < part.size(); ++level) {
+                for (T index : part[level]) schedule(buckets, level, index);
+            }
+        }
+    }
+
+public:
+    Generator(const TbMaterial& material, const TablebaseSet& smaller, int threadCount)
+        : material(material), smaller(smaller), threadCount(threadCount),
+          state(material.entryCount()), plies(material.entryCount(), 0), remaining(material.entryCount()),
+          external(material.entryCount(), 0), externalLoss(material.entryCount(), 0) {}
+
+    void run(std::vector<uint8_t>& wdl, std::vector<uint8_t>& result) {
+        uint64_t count = material.entryCount();
+        std::vector<std::vector<std::vector<uint32_t>>> localWins(threadCount), localLosses(threadCount);
+        parallel(count, [&](int t, uint64_t begin, uint64_t end) {
+            classify(begin, end, localWins[t], localLosses[t]);
+        });
+        mergeBuckets(localWins, winAt);
+        mergeBuckets(localLosses, lossAt);
+
+        for (size_t level = 0; level < std::max(winAt.size(), lossAt.size()); ++level) {
+            std::vector<uint32_t> frontier;
+            for (int result = GEN_WIN; result <= GEN_LOSS; ++result) {
+                std::vector<std::vector<uint32_t>>& buckets = result == GEN_WIN ? winAt : lossAt;
+                if (level >= buckets.size()) continue;
+                for (uint32_t index : buckets[level]) {
+                    uint8_t expected = GEN_UNKNOWN;
+                    if (state[index].compare_exchange_strong(expected, result)) {
+                        plies[index] = level;
+                        frontier.push_back(index);
+                    }
+                }
+                std::vector<uint32_t>().swap(buckets[level]);
+            }
+
+            std::vector<std::vector<std::vector<uint32_t>>> nextWins(threadCount), nextLosses(threadCount);
+            parallel(frontier.size(), [&](int t, uint64_t begin, uint64_t end) {
+                for (uint64_t k = begin; k < end; ++k) {
+                    uint32_t index = frontier[k];
+                    bool lost = state[index] == GEN_LOSS;
+                    forEachPredecessor(index, [&](uint64_t previous) {
+                        if (state[previous] != GEN_UNKNOWN) return;
+                        if (lost) {
+                            schedule(nextWins[t], level + 1, previous);
+                        } else if (remaining[previous].fetch_sub(1) == 1 && external[previous] == 0) {
+                            schedule(nextLosses[t], std::max<int>(level + 1, externalLoss[previous]), previous);
+                        }
+                    });
+                }
+            });
+            mergeBuckets(nextWins, winAt);
+            mergeBuckets(nextLosses, lossAt);
+        }
+
+        wdl.assign(count, TB_DRAW);
+        result.assign(count, 0);
+        for (uint64_t index = 0; index < count; ++index) {
+            switch (state[index]) {
+                case GEN_WIN:     wdl[index] = TB_WIN; break;
+                case GEN_LOSS:    wdl[index] = TB_LOSS; break;
+                case GEN_ILLEGAL: wdl[index] = TB_ILLEGAL; break;
+                default:          wdl[index] = TB_DRAW; break;
+            }
+            result[index] = plies[index];
+        }
+    }
+};
+
+// Tables reached by captures and promotions, which must exist before this one is generated
+std::vector<std::string> dependencies(const TbMaterial& material) {
+    std::vector<std::string> result;
+    auto add = [&](const std::string& white, const std::string& black) {
+        if (!isInsufficientMaterial(white, black)) {
+            std::string name = normalizeMaterial(white, black);
+            if (std::find(result.begin(), result.end(), name) == result.end()) result.push_back(name);
+        }
+    };
+    for (int side = 0; side < 2; ++side) {
+        const std::string& own = side == 0 ? material.white : material.black;
+        const std::string& other = side == 0 ? material.black : material.white;
+        for (size_t i = 0; i < own.size(); ++i) {
+            std::string without = own.substr(0, i) + own.substr(i + 1);
+            side == 0 ? add(without, other) : add(other, without);
+            if (own[i] == 'P') {
+                for (char promotion : std::string("QRBN")) {
+                    side == 0 ? add(without + promotion, other) : add(other, without + promotion);
+                    // Promotion with capture
+                    for (size_t j = 0; j < other.size(); ++j) {
+                        std::string captured = other.substr(0, j) + other.substr(j + 1);
+                        side == 0 ? add(without + promotion, captured) : add(captured, without + promotion);
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+std::string toFEN(const TbMaterial& material, const int* squares, Color side) {
+    std::string fen;
+    for (int row = 0; row < BOARD_SIZE; ++row) {
+        int empty = 0;
+        for (int file = 0; file < BOARD_SIZE; ++file) {
+            int slot = -1;
+            for (int i = 0; i < material.count; ++i) {
+                if (squares[i] == squareIndex(file, row)) slot = i;
+            }
+            if (slot < 0) {
+                ++empty;
+                continue;
+            }
+            if (empty) fen += std::to_string(empty);
+            empty = 0;
+            char letter = pieceLetter(material.types[slot]);
+            fen += material.colors[slot] == WHITE ? letter : (char)tolower(letter);
+        }
+        if (empty) fen += std::to_string(empty);
+        if (row < BOARD_SIZE - 1) fen += '/';
+    }
+    return fen + (side == WHITE ? " w - - 0 1" : " b - - 0 1");
+}
+
+// Random legal positions: every probed result must agree with a one-ply search using ChessBoard.
+// Positions with a double push that allows an en-passant reply are skipped, because the tables
+// are generated without en passant and their values may differ from full chess there.
+bool verify(const TablebaseSet& set, const Tablebase& table, int samples) {
+    const TbMaterial& material = table.getMaterial();
+    std::mt19937_64 random(12345);
+    int checked = 0, failures = 0, skipped = 0;
+
+    for (int attempt = 0; checked < samples && attempt < samples * 100; ++attempt) {
+        uint64_t index = random() % table.size();
+        TablebaseResult expected = table.read(index);
+        if (expected.wdl == TB_ILLEGAL) continue;
+
+        int squares[MAX_TB_PIECES];
+        Color side;
+        tbDecode(material, index, squares, side);
+        ChessBoard board;
+        board.setFEN(toFEN(material, squares, side));
+
+        TablebaseResult probed;
+        if (!set.probe(board, probed) || probed.wdl != expected.wdl || probed.plies != expected.plies) {
+            ++failures;
+            continue;
+        }
+
+        // Best child from the mover's point of view
+        MoveList list;
+        board.generateMoves(list);
+        bool consistent;
+        if (list.size == 0) {
+            consistent = expected.wdl == (board.inCheck() ? TB_LOSS : TB_DRAW) && expected.plies == 0;
+        } else {
+            int bestWin = INT_MAX, worstLoss = -1;
+            bool draw = false, enPassant = false;
+            for (int i = 0; i < list.size; ++i) {
+                board.makeMove(list[i]);
+                TablebaseResult child;
+                bool found = set.probe(board, child);
+                enPassant = enPassant || board.canCaptureEnPassant();
+                board.unmakeMove();
+                if (!found) {
+                    draw = true; // e.g. a move into a table that was not generated
+                    continue;
+                }
+                if (child.wdl == TB_LOSS) bestWin = std::min(bestWin, child.plies + 1);
+                else if (child.wdl == TB_WIN) worstLoss = std::max(worstLoss, child.plies + 1);
+                else draw = true;
+            }
+            if (enPassant) {
+                ++skipped;
+                continue;
+            }
+            if (bestWin != INT_MAX) consistent = expected.wdl == TB_WIN && expected.plies == bestWin;
+            else if (draw) consistent = expected.wdl == TB_DRAW;
+            else consistent = expected.wdl == TB_LOSS && expected.plies == worstLoss;
+        }
+        failures += !consistent;
+        ++checked;
+    }
+
+    std::cout << "  verified " << checked << " random positions against ChessBoard: "
+              << (failures ? std::to_string(failures) + " FAILED" : std::string("OK"));
+    if (skipped) std::cout << " (" << skipped << " skipped for en passant)";
+    std::cout << std::endl;
+    return failures == 0;
+}
+
+bool generate(const std::string& name, const std::string& directory, TablebaseSet& set, int threadCount, bool check) {
+    if (set.has(name)) {
+        return true;
+    }
+    TbMaterial material;
+    if (!material.parse(name)) {
+        std::cerr << "Invalid material " << name << " (at most " << MAX_TB_PIECES << " pieces, e.g. KQKR)" << std::endl;
+        return false;
+    }
+    for (const std::string& dependency : dependencies(material)) {
+        if (!generate(dependency, directory, set, threadCount, check)) return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> wdl, plies;
+    Generator(material, set, threadCount).run(wdl, plies);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::string path = directory + "/" + name + ".tb";
+    if (!Tablebase::write(path, material, wdl, plies) || !set.add(path)) {
+        std::cerr << "Cannot write " << path << std::endl;
+        return false;
+    }
+
+    uint64_t counts[4] = {};
+    int longestWin = 0;
+    for (uint64_t i = 0; i < wdl.size(); ++i) {
+        ++counts[wdl[i]];
+        if (wdl[i] == TB_WIN) longestWin = std::max<int>(longestWin, plies[i]);
+    }
+    int longestMate = (longestWin + 1) / 2;
+    std::cout << name << ": " << wdl.size() << " entries in " << seconds << " s, "
+              << counts[TB_WIN] << " wins, " << counts[TB_DRAW] << " draws, " << counts[TB_LOSS] << " losses, "
+              << counts[TB_ILLEGAL] << " illegal; longest mate " << longestMate << " moves" << std::endl;
+
+    bool ok = true;
+    for (const KnownResult& known : KNOWN_RESULTS) {
+        if (name == known.material) {
+            ok = longestMate == known.maxMateMoves;
+            std::cout << "  expected longest mate " << known.maxMateMoves << " moves: " << (ok ? "OK" : "FAILED") << std::endl;
+        }
+    }
+    if (check) {
+        Tablebase table;
+        table.open(path);
+        ok = verify(set, table, 2000) && ok;
+    }
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    bool check = false;
+    std::vector<std::string> arguments;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--threads" && i + 1 < argc) {
+            threadCount = std::max(1, std::atoi(argv[++i]));
+        } else if (argument == "--verify") {
+            check = true;
+        } else {
+            arguments.push_back(argument);
+        }
+    }
+    if (arguments.size() < 2) {
+        std::cerr << "Usage: " << argv[0] << " [--threads N] [--verify] <directory> <material>..." << std::endl;
+        return 1;
+    }
+
+    mkdir(arguments[0].c_str(), 0755);
+    TablebaseSet set;
+    set.loadDirectory(arguments[0]);
+
+    bool ok = true;
+    for (size_t i = 1; i < arguments.size(); ++i) {
+        TbMaterial material;
+        std::string name = arguments[i];
+        if (material.parse(name)) {
+            name = normalizeMaterial(material.white, material.black);
+        }
+        ok = generate(name, arguments[0], set, threadCount, check) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,320 @@
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include "book.cpp"
+#include "search.cpp"
+
+// UCI front end. The main thread only reads commands, so it never blocks on the search;
+// the search runs on its own thread and polls SearchControl at every node.
+
+const int64_t MOVE_OVERHEAD_MICROSECONDS = 30000;
+const int DEFAULT_MOVES_TO_GO = 30;
+
+struct GoLimits {
+    int depth = MAX_DEPTH;
+    uint64_t nodes = 0;
+    int64_t moveTime = -1; // milliseconds
+    int64_t time[2] = {-1, -1};
+    int64_t increment[2] = {0, 0};
+    int movesToGo = 0;
+    bool infinite = false;
+    bool ponder = false;
+};
+
+class UciEngine {
+private:
+    ChessBoard board;
+    PolyglotBook book;
+    TablebaseSet tablebases;
+    std::mt19937_64 random;
+
+    SearchControl control;
+    std::thread searchThread;
+    GoLimits limits;
+    Color searchSide = WHITE;
+
+    // Guards output and the ponder/infinite wait before bestmove
+    std::mutex mutex;
+    std::condition_variable stateChanged;
+    bool pondering = false;
+
+    std::atomic<bool> debug{false};
+    int64_t goTime = 0;
+    std::atomic<int64_t> stopTime{0};
+    bool firstInfoSent = false;
+
+    void send(const std::string& line) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::cout << line << std::endl;
+    }
+
+    void waitForSearch() {
+        if (searchThread.joinable()) {
+            searchThread.join();
+        }
+    }
+
+    // Splits the clock into a soft limit (no new iteration) and a hard limit (abort now)
+    void allocateTime(int64_t start) {
+        Color us = searchSide;
+        if (limits.infinite) {
+            return;
+        }
+        if (limits.moveTime >= 0) {
+            int64_t budget = std::max<int64_t>(1000, limits.moveTime * 1000 - MOVE_OVERHEAD_MICROSECONDS);
+            control.softDeadline = start + budget;
+            control.hardDeadline = start + budget;
+            return;
+        }
+        if (limits.time[us] < 0) {
+            return;
+        }
+
+        int64_t remaining = limits.time[us] * 1000;
+        int movesToGo = limits.movesToGo > 0 ? limits.movesToGo : DEFAULT_MOVES_TO_GO;
+        int64_t budget = remaining / movesToGo + limits.increment[us] * 1000 * 3 / 4;
+        int64_t maximum = std::max<int64_t>(1000, remaining - MOVE_OVERHEAD_MICROSECONDS);
+        budget = std::min(budget, maximum);
+
+        // Another iteration usually costs more than all previous ones together
+        control.softDeadline = start + budget / 2;
+        control.hardDeadline = start + std::min(budget * 3, maximum);
+    }
+
+    std::string formatScore(int score) const {
+        if (score >= MATE_BOUND) {
+            return "mate " + std::to_string((MATE_SCORE - score + 1) / 2);
+        }
+        if (score <= -MATE_BOUND) {
+            return "mate -" + std::to_string((MATE_SCORE + score) / 2);
+        }
+        return "cp " + std::to_string(score);
+    }
+
+    void reportInfo(const SearchInfo& info) {
+        int64_t elapsed = std::max<int64_t>(1, info.elapsedMicroseconds);
+        std::ostringstream line;
+        line << "info depth " << info.depth << " score " << formatScore(info.score)
+             << " nodes " << info.nodes << " nps " << info.nodes * 1000000 / elapsed
+             << " time " << elapsed / 1000 << " pv";
+        for (int i = 0; i < info.pvLength; ++i) {
+            line << ' ' << toUCI(info.pv[i]);
+        }
+        send(line.str());
+
+        if (!firstInfoSent) {
+            firstInfoSent = true;
+            if (debug) {
+                send("info string go to first info " + std::to_string(nowMicroseconds() - goTime) + " us");
+            }
+        }
+    }
+
+    void searchMain() {
+        Move best, ponder;
+        bool hasPonder = false;
+        bool found = false;
+
+        if (book.isOpen() && book.pickMove(board, random(), best)) {
+            send("info string book move " + toUCI(best));
+            found = true;
+        } else {
+            Searcher searcher(board, control, [this](const SearchInfo& info) { reportInfo(info); });
+            searcher.setTablebases(&tablebases);
+            found = searcher.run(limits.depth, limits.nodes, best, ponder, hasPonder);
+        }
+
+        // UCI forbids bestmove while pondering or in infinite mode until the GUI says so
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            stateChanged.wait(lock, [this] {
+                return control.stop.load() || (!pondering && !limits.infinite);
+            });
+        }
+
+        if (debug && stopTime.load() != 0) {
+            send("info string stop to bestmove " + std::to_string(nowMicroseconds() - stopTime.load()) + " us");
+        }
+        if (!found) {
+            send("bestmove 0000");
+        } else if (hasPonder) {
+            send("bestmove " + toUCI(best) + " ponder " + toUCI(ponder));
+        } else {
+            send("bestmove " + toUCI(best));
+        }
+    }
+
+    void position(std::istringstream& in) {
+        std::string token, fen;
+        in >> token;
+        if (token == "startpos") {
+            fen = START_FEN;
+            in >> token;
+        } else if (token == "fen") {
+            while (in >> token && token != "moves") {
+                fen += (fen.empty() ? "" : " ") + token;
+            }
+        } else {
+            return;
+        }
+
+        if (!board.setFEN(fen)) {
+            send("info string invalid fen " + fen);
+            board.setFEN(START_FEN);
+            return;
+        }
+        while (in >> token) {
+            Move move;
+            if (!board.parseMove(token, move)) {
+                send("info string illegal move " + token);
+                return;
+            }
+            // Keep the game history for repetition detection, but leave room for the search
+            if (board.getPly() >= MAX_PLY - MAX_DEPTH - 1) {
+                board.clearHistory();
+            }
+            board.makeMove(move);
+        }
+    }
+
+    void go(std::istringstream& in) {
+        stop();
+        waitForSearch();
+
+        goTime = nowMicroseconds();
+        stopTime = 0;
+        firstInfoSent = false;
+
+        limits = GoLimits();
+        std::string token;
+        while (in >> token) {
+            if (token == "depth") in >> limits.depth;
+            else if (token == "nodes") in >> limits.nodes;
+            else if (token == "movetime") in >> limits.moveTime;
+            else if (token == "wtime") in >> limits.time[WHITE];
+            else if (token == "btime") in >> limits.time[BLACK];
+            else if (token == "winc") in >> limits.increment[WHITE];
+            else if (token == "binc") in >> limits.increment[BLACK];
+            else if (token == "movestogo") in >> limits.movesToGo;
+            else if (token == "infinite") limits.infinite = true;
+            else if (token == "ponder") limits.ponder = true;
+        }
+
+        control.reset();
+        searchSide = board.getSideToMove();
+        pondering = limits.ponder;
+        if (!pondering) {
+            allocateTime(goTime);
+        }
+        searchThread = std::thread(&UciEngine::searchMain, this);
+    }
+
+    void stop() {
+        if (stopTime.load() == 0) {
+            stopTime = nowMicroseconds();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            control.stop = true;
+        }
+        stateChanged.notify_all();
+    }
+
+    // The opponent played the expected move: keep searching, but on our own clock from now on
+    void ponderHit() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pondering = false;
+            allocateTime(nowMicroseconds());
+        }
+        stateChanged.notify_all();
+    }
+
+    void setOption(std::istringstream& in) {
+        std::string token, name, value;
+        in >> token; // "name"
+        while (in >> token && token != "value") {
+            name += (name.empty() ? "" : " ") + token;
+        }
+        std::getline(in >> std::ws, value);
+
+        if (name == "BookFile") {
+            if (value.empty() || value == "<empty>") {
+                book.close();
+            } else if (!book.open(value)) {
+                send("info string cannot open book " + value);
+            }
+        } else if (name == "TablebasePath") {
+            int loaded = tablebases.loadDirectory(value);
+            send("info string loaded " + std::to_string(loaded) + " tablebases from " + value);
+        }
+    }
+
+public:
+    UciEngine() : random(std::random_device{}()) {
+        board.setFEN(START_FEN);
+    }
+
+    ~UciEngine() {
+        stop();
+        waitForSearch();
+    }
+
+    // Returns false on "quit"
+    bool handle(const std::string& line) {
+        std::istringstream in(line);
+        std::string command;
+        in >> command;
+
+        if (command == "uci") {
+            send("id name ChessBoard");
+            send("id author tolstovr");
+            send("option name Ponder type check default false");
+            send("option name BookFile type string default <empty>");
+            send("option name TablebasePath type string default <empty>");
+            send("uciok");
+        } else if (command == "isready") {
+            send("readyok");
+        } else if (command == "debug") {
+            std::string mode;
+            in >> mode;
+            debug = mode == "on";
+        } else if (command == "setoption") {
+            // The search thread probes the book and the tablebases that an option may replace
+            stop();
+            waitForSearch();
+            setOption(in);
+        } else if (command == "ucinewgame") {
+            stop();
+            waitForSearch();
+            board.setFEN(START_FEN);
+        } else if (command == "position") {
+            stop();
+            waitForSearch();
+            position(in);
+        } else if (command == "go") {
+            go(in);
+        } else if (command == "stop") {
+            stop();
+        } else if (command == "ponderhit") {
+            ponderHit();
+        } else if (command == "quit") {
+            return false;
+        }
+        return true;
+    }
+};
+
+int main() {
+    std::ios::sync_with_stdio(false);
+
+    UciEngine engine;
+    std::string line;
+    while (std::getline(std::cin, line) && engine.handle(line)) {
+    }
+
+    return 0;
+}
@@ -1,5 +1,9 @@
+#pragma once
+
 #include <iostream>
 
+#include "instrument.cpp"
+
 template <typename T>
 class List {
 private:
@@ -16,11 +20,30 @@ private:
 public:
     List() : head(nullptr), tail(nullptr) {}
 
+    // Copies are deep; see PersistentList for copies that share nodes
+    List(const List& other) : head(nullptr), tail(nullptr) {
+        for (Node* current = other.head; current != nullptr; current = current->next) {
+            add(current->data);
+        }
+    }
+
+    List& operator=(const List& other) {
+        if (this != &other) {
+            clear();
+            for (Node* current = other.head; current != nullptr; current = current->next) {
+                add(current->data);
+            }
+        }
+        return *this;
+    }
+
     ~List() {
         clear();
     }
 
     void add(T value) {
+        INSTRUMENT_TIMER(LIST_ADD_LATENCY);
+        INSTRUMENT_COUNT(LIST_NODE_ALLOCATIONS);
         Node* newNode = new Node(value);
         if (!head) {
             head = tail = newNode;
@@ -31,10 +54,13 @@ public:
     }
 
     void remove(T value) {
+        INSTRUMENT_TIMER(LIST_REMOVE_LATENCY);
+        INSTRUMENT_COUNT(LIST_REMOVE_CALLS);
         Node* current = head;
         Node* previous = nullptr;
 
         while (current != nullptr) {
+            INSTRUMENT_COUNT(LIST_REMOVE_NODES);
             if (current->data == value) {
                 if (previous == nullptr) {
                     head = current->next;
@@ -47,6 +73,7 @@ public:
                         tail = previous;
                     }
                 }
+                INSTRUMENT_COUNT(LIST_NODE_FREES);
                 delete current;
                 return;
             }
@@ -56,8 +83,11 @@ public:
     }
 
     void insert(int index, T value) {
+        INSTRUMENT_TIMER(LIST_INSERT_LATENCY);
+        INSTRUMENT_COUNT(LIST_INSERT_CALLS);
         if (index < 0) return;
 
+        INSTRUMENT_COUNT(LIST_NODE_ALLOCATIONS);
         Node* newNode = new Node(value);
         if (index == 0) {
             newNode->next = head;
@@ -70,6 +100,7 @@ public:
 
         Node* current = head;
         for (int i = 0; i < index - 1 && current != nullptr; ++i) {
+            INSTRUMENT_COUNT(LIST_INSERT_NODES);
             current = current->next;
         }
 
@@ -85,8 +116,11 @@ public:
     }
 
     bool find(T value) const {
+        INSTRUMENT_TIMER(LIST_FIND_LATENCY);
+        INSTRUMENT_COUNT(LIST_FIND_CALLS);
         Node* current = head;
         while (current != nullptr) {
+            INSTRUMENT_COUNT(LIST_FIND_NODES);
             if (current->data == value)
                 return true;
             current = current->next;
@@ -98,6 +132,7 @@ public:
         while (head != nullptr) {
             Node* temp = head;
             head = head->next;
+            INSTRUMENT_COUNT(LIST_NODE_FREES);
             delete temp;
         }
         tail = nullptr;
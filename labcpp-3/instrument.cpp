@@ -0,0 +1,317 @@
+#pragma once
+
+// Counters and latency histograms for the hot paths of List, PersistentList and Complex.
+// Compile with -DLAB_INSTRUMENT to enable them; otherwise every INSTRUMENT_* macro expands to
+// nothing and the instrumented code is exactly the same as without this file.
+//
+// Every thread counts into its own block, so counting never takes a lock or shares a cache line.
+// instrumentReport() merges the blocks of all threads (including finished ones) on demand.
+// With instrumentation enabled, a report is written at exit, when an uncaught exception
+// terminates the program and whenever the process receives SIGUSR1: text to stderr, JSON to the
+// file named by LAB_INSTRUMENT_JSON if that is set.
+
+enum InstrumentCounter {
+    LIST_NODE_ALLOCATIONS,
+    LIST_NODE_FREES,
+    LIST_FIND_CALLS,
+    LIST_FIND_NODES,
+    LIST_INSERT_CALLS,
+    LIST_INSERT_NODES,
+    LIST_REMOVE_CALLS,
+    LIST_REMOVE_NODES,
+    PERSISTENT_NODE_COPIES,
+    COMPLEX_CONSTRUCTOR_CHECKS,
+    COMPLEX_CONSTRUCTOR_FAILURES,
+    ERROR_STRING,
+    ERROR_INT,
+    ERROR_LONG_DOUBLE,
+    ERROR_SIZE_T,
+    ERROR_MEMORY,
+    ERROR_FILE,
+    INSTRUMENT_COUNTER_COUNT
+};
+
+enum InstrumentHistogram {
+    LIST_ADD_LATENCY,
+    LIST_INSERT_LATENCY,
+    LIST_FIND_LATENCY,
+    LIST_REMOVE_LATENCY,
+    INSTRUMENT_HISTOGRAM_COUNT
+};
+
+#ifdef LAB_INSTRUMENT
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+const char* const INSTRUMENT_COUNTER_NAMES[INSTRUMENT_COUNTER_COUNT] = {
+    "list_node_allocations", "list_node_frees",
+    "list_find_calls", "list_find_nodes",
+    "list_insert_calls", "list_insert_nodes",
+    "list_remove_calls", "list_remove_nodes",
+    "persistent_node_copies",
+    "complex_constructor_checks", "complex_constructor_failures",
+    "error_string", "error_int", "error_long_double", "error_size_t", "error_memory", "error_file"
+};
+
+const char* const INSTRUMENT_HISTOGRAM_NAMES[INSTRUMENT_HISTOGRAM_COUNT] = {
+    "list_add_ns", "list_insert_ns", "list_find_ns", "list_remove_ns"
+};
+
+// Bucket i holds latencies in [2^(i-1), 2^i) nanoseconds; bucket 0 holds zero
+const int INSTRUMENT_BUCKETS = 40;
+
+// Merged view of all threads; plain values that can be copied around and printed
+struct InstrumentReport {
+    int threads = 0;
+    uint64_t counters[INSTRUMENT_COUNTER_COUNT] = {};
+    uint64_t buckets[INSTRUMENT_HISTOGRAM_COUNT][INSTRUMENT_BUCKETS] = {};
+    uint64_t sums[INSTRUMENT_HISTOGRAM_COUNT] = {};
+    uint64_t maxima[INSTRUMENT_HISTOGRAM_COUNT] = {};
+
+    uint64_t count(int histogram) const {
+        uint64_t total = 0;
+        for (int i = 0; i < INSTRUMENT_BUCKETS; ++i) total += buckets[histogram][i];
+        return total;
+    }
+
+    // Upper bound of the bucket that contains the given fraction of the samples
+    uint64_t percentile(int histogram, double fraction) const {
+        uint64_t total = count(histogram);
+        uint64_t seen = 0;
+        for (int i = 0; i < INSTRUMENT_BUCKETS; ++i) {
+            seen += buckets[histogram][i];
+            if (total && seen >= fraction * total) {
+                return i ? std::min<uint64_t>((uint64_t)1 << i, maxima[histogram]) : 0;
+            }
+        }
+        return 0;
+    }
+
+    void printText(std::ostream& out) const {
+        out << "Instrumentation report (" << threads << " threads)\n";
+        for (int i = 0; i < INSTRUMENT_COUNTER_COUNT; ++i) {
+            out << "  " << INSTRUMENT_COUNTER_NAMES[i] << ": " << counters[i] << "\n";
+        }
+        for (int h = 0; h < INSTRUMENT_HISTOGRAM_COUNT; ++h) {
+            uint64_t total = count(h);
+            if (!total) continue;
+            out << "  " << INSTRUMENT_HISTOGRAM_NAMES[h] << ": " << total << " calls, mean " << sums[h] / total
+                << ", p50 <= " << percentile(h, 0.5) << ", p90 <= " << percentile(h, 0.9) << ", p99 <= "
+                << percentile(h, 0.99) << ", max " << maxima[h] << "\n";
+        }
+    }
+
+    void printJson(std::ostream& out) const {
+        out << "{\n  \"threads\": " << threads << ",\n  \"counters\": {";
+        for (int i = 0; i < INSTRUMENT_COUNTER_COUNT; ++i) {
+            out << (i ? ", " : "") << "\"" << INSTRUMENT_COUNTER_NAMES[i] << "\": " << counters[i];
+        }
+        out << "},\n  \"histograms\": {";
+        for (int h = 0; h < INSTRUMENT_HISTOGRAM_COUNT; ++h) {
+            out << (h ? "," : "") << "\n    \"" << INSTRUMENT_HISTOGRAM_NAMES[h] << "\": {\"count\": " << count(h)
+                << ", \"sum\": " << sums[h] << ", \"max\": " << maxima[h] << ", \"p50\": " << percentile(h, 0.5)
+                << ", \"p90\": " << percentile(h, 0.9) << ", \"p99\": " << percentile(h, 0.99) << ", \"buckets\": [";
+            for (int i = 0; i < INSTRUMENT_BUCKETS; ++i) {
+                out << (i ? ", " : "") << buckets[h][i];
+            }
+            out << "]}";
+        }
+        out << "\n  }\n}\n";
+    }
+};
+
+// One per thread. Only the owning thread writes; the relaxed atomics let the reporting thread
+// read a consistent value of every field without a data race, and compile to plain moves.
+struct InstrumentStats {
+    std::atomic<uint64_t> counters[INSTRUMENT_COUNTER_COUNT] = {};
+    std::atomic<uint64_t> buckets[INSTRUMENT_HISTOGRAM_COUNT][INSTRUMENT_BUCKETS] = {};
+    std::atomic<uint64_t> sums[INSTRUMENT_HISTOGRAM_COUNT] = {};
+    std::atomic<uint64_t> maxima[INSTRUMENT_HISTOGRAM_COUNT] = {};
+
+    static void bump(std::atomic<uint64_t>& value, uint64_t amount) {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    void add(InstrumentCounter counter, uint64_t amount) {
+        bump(counters[counter], amount);
+    }
+
+    void record(InstrumentHistogram histogram, uint64_t nanoseconds) {
+        int bucket = 0;
+        while (bucket < INSTRUMENT_BUCKETS - 1 && nanoseconds >> bucket) ++bucket;
+        bump(buckets[histogram][bucket], 1);
+        bump(sums[histogram], nanoseconds);
+        if (nanoseconds > maxima[histogram].load(std::memory_order_relaxed)) {
+            maxima[histogram].store(nanoseconds, std::memory_order_relaxed);
+        }
+    }
+
+    void mergeInto(InstrumentReport& report) const {
+        for (int i = 0; i < INSTRUMENT_COUNTER_COUNT; ++i) {
+            report.counters[i] += counters[i].load(std::memory_order_relaxed);
+        }
+        for (int h = 0; h < INSTRUMENT_HISTOGRAM_COUNT; ++h) {
+            for (int i = 0; i < INSTRUMENT_BUCKETS; ++i) {
+                report.buckets[h][i] += buckets[h][i].load(std::memory_order_relaxed);
+            }
+            report.sums[h] += sums[h].load(std::memory_order_relaxed);
+            report.maxima[h] = std::max(report.maxima[h], maxima[h].load(std::memory_order_relaxed));
+        }
+    }
+};
+
+inline void instrumentDump();
+
+// Owns the list of live threads and the totals of the threads that have already finished.
+// Created on first use and never destroyed, so it outlives every thread_local and atexit handler.
+class InstrumentRegistry {
+private:
+    std::mutex mutex;
+    std::vector<const InstrumentStats*> live;
+    InstrumentReport finished;
+    int signalPipe[2] = {-1, -1};
+    static inline int signalFd = -1;
+    static inline std::terminate_handler previousTerminate = nullptr;
+
+    static void onSignal(int) {
+        char byte = 0;
+        if (write(signalFd, &byte, 1) < 0) {
+            // Nothing useful can be done about it inside a signal handler
+        }
+    }
+
+    // The handler only wakes this thread up; the report itself is built outside the handler
+    void watchSignal() {
+        if (pipe(signalPipe) != 0) return;
+        signalFd = signalPipe[1];
+        std::thread([this] {
+            char byte;
+            while (read(signalPipe[0], &byte, 1) > 0) {
+                instrumentDump();
+            }
+        }).detach();
+        std::signal(SIGUSR1, onSignal);
+    }
+
+    // std::terminate skips atexit handlers, so an uncaught exception reports here and then
+    // terminates the way it would have without instrumentation
+    static void onTerminate() {
+        instrumentDump();
+        if (previousTerminate) previousTerminate();
+        std::abort();
+    }
+
+    InstrumentRegistry() {
+        watchSignal();
+        std::atexit(instrumentDump);
+        previousTerminate = std::set_terminate(onTerminate);
+    }
+
+public:
+    static InstrumentRegistry& instance() {
+        static InstrumentRegistry* registry = new InstrumentRegistry();
+        return *registry;
+    }
+
+    void attach(const InstrumentStats* stats) {
+        std::lock_guard<std::mutex> lock(mutex);
+        live.push_back(stats);
+    }
+
+    void detach(const InstrumentStats* stats) {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats->mergeInto(finished);
+        ++finished.threads;
+        live.erase(std::find(live.begin(), live.end(), stats));
+    }
+
+    InstrumentReport report() {
+        std::lock_guard<std::mutex> lock(mutex);
+        InstrumentReport report = finished;
+        for (const InstrumentStats* stats : live) {
+            stats->mergeInto(report);
+            ++report.threads;
+        }
+        return report;
+    }
+};
+
+// Registers the thread's block on its first instrumented operation and folds it into the
+// registry's totals when the thread exits
+struct InstrumentThread {
+    InstrumentStats stats;
+
+    InstrumentThread() {
+        InstrumentRegistry::instance().attach(&stats);
+    }
+
+    ~InstrumentThread() {
+        InstrumentRegistry::instance().detach(&stats);
+    }
+};
+
+inline InstrumentStats& instrumentThreadStats() {
+    thread_local InstrumentThread thread;
+    return thread.stats;
+}
+
+// Creates the registry during static initialization, so that SIGUSR1 and the terminate handler
+// are in place before the first counter is touched
+inline const bool instrumentInstalled = (InstrumentRegistry::instance(), true);
+
+inline InstrumentReport instrumentReport() {
+    return InstrumentRegistry::instance().report();
+}
+
+inline void instrumentDump() {
+    InstrumentReport report = instrumentReport();
+    report.printText(std::cerr);
+    if (const char* path = std::getenv("LAB_INSTRUMENT_JSON")) {
+        std::ofstream file(path);
+        report.printJson(file);
+    }
+}
+
+// Records the lifetime of the enclosing scope in a histogram
+class InstrumentTimer {
+private:
+    InstrumentHistogram histogram;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit InstrumentTimer(InstrumentHistogram histogram)
+        : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+
+    ~InstrumentTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        instrumentThreadStats().record(histogram, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+};
+
+#define INSTRUMENT_CONCAT_(a, b) a##b
+#define INSTRUMENT_CONCAT(a, b) INSTRUMENT_CONCAT_(a, b)
+
+#define INSTRUMENT_COUNT(counter) instrumentThreadStats().add(counter, 1)
+#define INSTRUMENT_ADD(counter, amount) instrumentThreadStats().add(counter, amount)
+#define INSTRUMENT_TIMER(histogram) InstrumentTimer INSTRUMENT_CONCAT(instrumentTimer, __LINE__)(histogram)
+
+#else
+
+#define INSTRUMENT_COUNT(counter) ((void)0)
+#define INSTRUMENT_ADD(counter, amount) ((void)0)
+#define INSTRUMENT_TIMER(histogram) ((void)0)
+
+#endif
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <utility>
+
+#include "instrument.cpp"
+
+// List with the same interface as List<T> whose copies are O(1): copies share their nodes, and
+// every node counts the links and lists that point to it. A node is never changed while another
+// list can see it, so a copy is a frozen snapshot that can be read from another thread while the
+// original keeps changing.
+//
+// A list sees exactly its first `count` nodes; the chain may continue past its tail because
+// another list appended to it. Changing the first k nodes copies only those of them that are
+// shared (the rest of the chain stays shared), and nothing when the list is their only owner.
+// Appending claims the tail's next pointer with a compare-and-swap, so a writer that keeps
+// appending while readers hold snapshots never copies anything.
+template <typename T>
+class PersistentList {
+private:
+    struct Node {
+        const T data;
+        std::atomic<Node*> next;
+        std::atomic<int> refs;
+
+        Node(const T& value, Node* next) : data(value), next(next), refs(1) {}
+    };
+
+    Node* head;
+    Node* tail;
+    size_t count;
+
+    static Node* newNode(const T& value, Node* next) {
+        INSTRUMENT_COUNT(LIST_NODE_ALLOCATIONS);
+        return new Node(value, next);
+    }
+
+    static void retain(Node* node) {
+        if (node) node->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void release(Node* node) {
+        while (node && node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            INSTRUMENT_COUNT(LIST_NODE_FREES);
+            delete node;
+            node = next;
+        }
+    }
+
+    // Makes the first `length` nodes (1 <= length <= count) private to this list and returns
+    // the last of them. Everything after the first shared node is reachable by other lists
+    // through it, so the copy starts there.
+    Node* ownPrefix(size_t length) {
+        Node* previous = nullptr;
+        Node* current = head;
+        size_t i = 0;
+        while (i < length && current->refs.load(std::memory_order_acquire) == 1) {
+            previous = current;
+            current = current->next.load(std::memory_order_acquire);
+            ++i;
+        }
+        if (i == length) {
+            return previous;
+        }
+
+        Node* shared = current;
+        Node* copyHead = nullptr;
+        Node* copyTail = nullptr;
+        for (; i < length; ++i) {
+            INSTRUMENT_COUNT(PERSISTENT_NODE_COPIES);
+            Node* copy = newNode(current->data, nullptr);
+            if (copyTail) {
+                copyTail->next.store(copy, std::memory_order_relaxed);
+            } else {
+                copyHead = copy;
+            }
+            copyTail = copy;
+            current = current->next.load(std::memory_order_acquire);
+        }
+
+        if (length < count) {
+            retain(current);
+            copyTail->next.store(current, std::memory_order_relaxed);
+        } else {
+            tail = copyTail;
+        }
+        if (previous) {
+            previous->next.store(copyHead, std::memory_order_relaxed);
+        } else {
+            head = copyHead;
+        }
+        release(shared);
+        return copyTail;
+    }
+
+public:
+    class Iterator {
+    private:
+        Node* node;
+        size_t remaining;
+
+    public:
+        Iterator(Node* node, size_t remaining) : node(node), remaining(remaining) {}
+
+        const T& operator*() const {
+            return node->data;
+        }
+
+        // Stops after the list's own nodes without reading the tail's next pointer,
+        // which a writer may be setting at the same time
+        Iterator& operator++() {
+            if (--remaining) node = node->next.load(std::memory_order_acquire);
+            return *this;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return remaining != other.remaining;
+        }
+    };
+
+    PersistentList() : head(nullptr), tail(nullptr), count(0) {}
+
+    PersistentList(const PersistentList& other) : head(other.head), tail(other.tail), count(other.count) {
+        retain(head);
+    }
+
+    PersistentList(PersistentList&& other) noexcept : head(other.head), tail(other.tail), count(other.count) {
+        other.head = other.tail = nullptr;
+        other.count = 0;
+    }
+
+    PersistentList& operator=(PersistentList other) {
+        std::swap(head, other.head);
+        std::swap(tail, other.tail);
+        std::swap(count, other.count);
+        return *this;
+    }
+
+    ~PersistentList() {
+        release(head);
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    Iterator begin() const {
+        return Iterator(head, count);
+    }
+
+    Iterator end() const {
+        return Iterator(nullptr, 0);
+    }
+
+    void add(T value) {
+        INSTRUMENT_TIMER(LIST_ADD_LATENCY);
+        Node* node = newNode(value, nullptr);
+        if (!head) {
+            head = tail = node;
+            count = 1;
+            return;
+        }
+
+        Node* expected = nullptr;
+        if (!tail->next.compare_exchange_strong(expected, node, std::memory_order_release, std::memory_order_relaxed)) {
+            // Another list has already appended after our tail: take our own copy of the
+            // shared part, after which the tail's next pointer is ours to replace
+            ownPrefix(count);
+            release(tail->next.exchange(node, std::memory_order_release));
+        }
+        tail = node;
+        ++count;
+    }
+
+    void remove(T value) {
+        INSTRUMENT_TIMER(LIST_REMOVE_LATENCY);
+        INSTRUMENT_COUNT(LIST_REMOVE_CALLS);
+        Node* current = head;
+        size_t index = 0;
+        for (; index < count; ++index) {
+            INSTRUMENT_COUNT(LIST_REMOVE_NODES);
+            if (current->data == value) break;
+            current = current->next.load(std::memory_order_acquire);
+        }
+        if (index == count) return;
+
+        if (index == 0) {
+            Node* next = count > 1 ? head->next.load(std::memory_order_acquire) : nullptr;
+            retain(next);
+            release(head);
+            head = next;
+            if (!head) tail = nullptr;
+        } else {
+            Node* previous = ownPrefix(index);
+            Node* victim = previous->next.load(std::memory_order_relaxed);
+            Node* next = nullptr;
+            if (index + 1 < count) {
+                next = victim->next.load(std::memory_order_acquire);
+                retain(next);
+            } else {
+                tail = previous;
+            }
+            previous->next.store(next, std::memory_order_relaxed);
+            release(victim);
+        }
+        --count;
+    }
+
+    void insert(int index, T value) {
+        INSTRUMENT_TIMER(LIST_INSERT_LATENCY);
+        INSTRUMENT_COUNT(LIST_INSERT_CALLS);
+        if (index < 0) return;
+
+        if ((size_t)index >= count) {
+            add(value);
+        } else if (index == 0) {
+            // The list's reference to the old head becomes the new node's link
+            head = newNode(value, head);
+            ++count;
+        } else {
+            INSTRUMENT_ADD(LIST_INSERT_NODES, index - 1);
+            Node* previous = ownPrefix(index);
+            previous->next.store(newNode(value, previous->next.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+            ++count;
+        }
+    }
+
+    bool find(T value) const {
+        INSTRUMENT_TIMER(LIST_FIND_LATENCY);
+        INSTRUMENT_COUNT(LIST_FIND_CALLS);
+        for (const T& data : *this) {
+            INSTRUMENT_COUNT(LIST_FIND_NODES);
+            if (data == value)
+                return true;
+        }
+        return false;
+    }
+
+    void clear() {
+        release(head);
+        head = tail = nullptr;
+        count = 0;
+    }
+
+    void print(std::ostream& out) const {
+        for (const T& data : *this) {
+            out << data << " -> ";
+        }
+        out << "nullptr" << std::endl;
+    }
+};